@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Простой двоичный формат для сохраненных баз: числа и массивы пишутся как есть,
+// в порядке байт машины (совместимость проверяет заголовок файла).
+// Массивы: uint64 длина + элементы; строки: uint64 длина + байты.
+namespace binary_io {
+
+class FormatError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+class Writer {
+public:
+    explicit Writer(std::ostream& out)
+        : out_(out) {
+    }
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+    template <typename T>
+    void WriteVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write<uint64_t>(values.size());
+        WriteBytes(values.data(), values.size() * sizeof(T));
+    }
+    void WriteString(const std::string& value) {
+        Write<uint64_t>(value.size());
+        WriteBytes(value.data(), value.size());
+    }
+    void WriteStrings(const std::vector<std::string>& values) {
+        Write<uint64_t>(values.size());
+        for (const std::string& value : values) {
+            WriteString(value);
+        }
+    }
+    // Дополняет нулями до границы alignment от начала файла
+    void Align(size_t alignment) {
+        static const char zeros[64] = {};
+        while (written_ % alignment != 0) {
+            size_t chunk = std::min(alignment - written_ % alignment, sizeof(zeros));
+            WriteBytes(zeros, chunk);
+        }
+    }
+    void WriteBytes(const void* data, size_t size) {
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written_ += size;
+    }
+    size_t GetWritten() const {
+        return written_;
+    }
+private:
+    std::ostream& out_;
+    size_t written_ = 0;
+};
+
+// Читает из готового блока памяти (обычно отображенного файла), выход за границы - FormatError
+class Reader {
+public:
+    Reader(const char* data, size_t size)
+        : data_(data), size_(size) {
+    }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    template <typename T>
+    std::vector<T> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        size_t count = ReadCount(sizeof(T));
+        std::vector<T> values(count);
+        if (count != 0) {
+            std::memcpy(values.data(), Take(count * sizeof(T)), count * sizeof(T));
+        }
+        return values;
+    }
+    std::string ReadString() {
+        size_t size = ReadCount(1);
+        const char* data = Take(size);
+        return std::string(data, size);
+    }
+    std::vector<std::string> ReadStrings() {
+        // у каждой строки минимум 8 байт длины
+        size_t count = ReadCount(sizeof(uint64_t));
+        std::vector<std::string> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            values.push_back(ReadString());
+        }
+        return values;
+    }
+    // Указатель на count элементов прямо в блоке, без копирования.
+    // Блок должен быть выровнен для T - писатель выравнивает его через Align
+    template <typename T>
+    const T* View(size_t count) {
+        if (pos_ % alignof(T) != 0) {
+            throw FormatError("Misaligned array in binary file");
+        }
+        if (count > (size_ - pos_) / sizeof(T)) {
+            throw FormatError("Array length exceeds binary file size");
+        }
+        return reinterpret_cast<const T*>(Take(count * sizeof(T)));
+    }
+    void Align(size_t alignment) {
+        size_t padded = (pos_ + alignment - 1) / alignment * alignment;
+        Take(padded - pos_);
+    }
+private:
+    const char* Take(size_t size) {
+        if (size > size_ - pos_) {
+            throw FormatError("Unexpected end of binary file");
+        }
+        const char* ptr = data_ + pos_;
+        pos_ += size;
+        return ptr;
+    }
+    size_t ReadCount(size_t element_size) {
+        uint64_t count = Read<uint64_t>();
+        if (count > (size_ - pos_) / element_size) {
+            throw FormatError("Array length exceeds binary file size");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+} // namespace binary_io
@@ -0,0 +1,337 @@
+#include "catalogue_snapshot.h"
+#include "binary_io.h"
+#include "geo.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace transport {
+
+    namespace {
+
+        constexpr char kSnapshotMagic[8] = { 'T', 'C', 'S', 'N', 'A', 'P', '0', '1' };
+        constexpr uint32_t kSnapshotVersion = 1;
+        constexpr uint32_t kByteOrderMark = 0x01020304;
+        constexpr size_t kSectionAlignment = 8;
+
+        struct Section {
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        size_t AlignUp(size_t value) {
+            return (value + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+        }
+
+    } // namespace
+
+    struct CatalogueSnapshot::Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        double wait_time;
+        double velocity;
+        StringRef map;
+        Section stops;
+        Section buses;
+        Section route;
+        Section stop_bus;
+        Section distances;
+        Section pool;
+    };
+
+    void CatalogueSnapshot::Write(const TransportCatalogue& tc, std::string_view map_svg, const std::string& path) {
+        using namespace std::literals;
+
+        std::string pool;
+        auto add_string = [&pool](std::string_view value) {
+            if (pool.size() + value.size() > UINT32_MAX) {
+                throw std::runtime_error("Catalogue snapshot string pool exceeds 4 GB"s);
+            }
+            StringRef ref{ static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(value.size()) };
+            pool.append(value);
+            return ref;
+        };
+
+        // номера остановок и автобусов - позиции в порядке имен
+        std::vector<std::string_view> stop_names;
+        for (const auto& [name, stop] : *tc.GetStops()) {
+            stop_names.push_back(name);
+        }
+        std::sort(stop_names.begin(), stop_names.end());
+        std::unordered_map<std::string_view, uint32_t> stop_ids;
+        for (uint32_t i = 0; i < stop_names.size(); ++i) {
+            stop_ids[stop_names[i]] = i;
+        }
+
+        std::vector<std::string_view> bus_names;
+        for (const auto& [number, bus] : *tc.GetBuses()) {
+            bus_names.push_back(number);
+        }
+        std::sort(bus_names.begin(), bus_names.end());
+        std::unordered_map<std::string_view, uint32_t> bus_ids;
+        for (uint32_t i = 0; i < bus_names.size(); ++i) {
+            bus_ids[bus_names[i]] = i;
+        }
+
+        std::vector<BusRecord> buses;
+        std::vector<uint32_t> route;
+        for (std::string_view number : bus_names) {
+            const Bus* bus = tc.GetBus(number);
+            BusRecord record{ add_string(number), static_cast<uint32_t>(route.size()), 0, bus->is_ring ? 1u : 0u, 0 };
+            for (const std::string& stop_name : bus->route) {
+                auto it = stop_ids.find(stop_name);
+                if (it == stop_ids.end()) {
+                    throw std::runtime_error("Bus "s + bus->number + " refers to unknown stop "s + stop_name);
+                }
+                route.push_back(it->second);
+            }
+            record.stops_end = static_cast<uint32_t>(route.size());
+            buses.push_back(record);
+        }
+
+        std::vector<StopRecord> stops;
+        std::vector<uint32_t> stop_bus;
+        for (std::string_view name : stop_names) {
+            const Stop* stop = tc.GetStop(name);
+            StopRecord record{ add_string(name), static_cast<uint32_t>(stop_bus.size()), 0,
+                stop->coordinate.latitude, stop->coordinate.longitude };
+            // множество отсортировано по имени, а номера автобусов идут в том же порядке
+            for (std::string_view bus_name : *tc.GetStopInformation(name)) {
+                stop_bus.push_back(bus_ids.at(bus_name));
+            }
+            record.buses_end = static_cast<uint32_t>(stop_bus.size());
+            stops.push_back(record);
+        }
+
+        std::vector<DistanceRecord> distances;
+        for (const auto& [stops_pair, distance] : *tc.GetRoadDistances()) {
+            auto from = stop_ids.find(stops_pair.first);
+            auto to = stop_ids.find(stops_pair.second);
+            if (from != stop_ids.end() && to != stop_ids.end()) {
+                distances.push_back({ from->second, to->second, distance });
+            }
+        }
+        std::sort(distances.begin(), distances.end(), [](const DistanceRecord& lhs, const DistanceRecord& rhs) {
+            return std::pair(lhs.from, lhs.to) < std::pair(rhs.from, rhs.to);
+        });
+
+        Header header{};
+        std::copy(std::begin(kSnapshotMagic), std::end(kSnapshotMagic), header.magic);
+        header.version = kSnapshotVersion;
+        header.byte_order = kByteOrderMark;
+        header.wait_time = tc.GetWaitTime();
+        header.velocity = tc.GetVelocity();
+        header.map = add_string(map_svg);
+
+        size_t offset = AlignUp(sizeof(Header));
+        auto place = [&offset](Section& section, size_t count, size_t element_size) {
+            section = { offset, count };
+            offset = AlignUp(offset + count * element_size);
+        };
+        place(header.stops, stops.size(), sizeof(StopRecord));
+        place(header.buses, buses.size(), sizeof(BusRecord));
+        place(header.route, route.size(), sizeof(uint32_t));
+        place(header.stop_bus, stop_bus.size(), sizeof(uint32_t));
+        place(header.distances, distances.size(), sizeof(DistanceRecord));
+        place(header.pool, pool.size(), 1);
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot create "s + path);
+        }
+        binary_io::Writer writer(out);
+        writer.Write(header);
+        auto write_section = [&writer](const Section& section, const void* data, size_t bytes) {
+            writer.Align(kSectionAlignment);
+            if (writer.GetWritten() != section.offset) {
+                throw std::logic_error("Catalogue snapshot layout mismatch");
+            }
+            writer.WriteBytes(data, bytes);
+        };
+        write_section(header.stops, stops.data(), stops.size() * sizeof(StopRecord));
+        write_section(header.buses, buses.data(), buses.size() * sizeof(BusRecord));
+        write_section(header.route, route.data(), route.size() * sizeof(uint32_t));
+        write_section(header.stop_bus, stop_bus.data(), stop_bus.size() * sizeof(uint32_t));
+        write_section(header.distances, distances.data(), distances.size() * sizeof(DistanceRecord));
+        write_section(header.pool, pool.data(), pool.size());
+        if (!out.flush()) {
+            throw std::runtime_error("Cannot write "s + path);
+        }
+    }
+
+    CatalogueSnapshot::CatalogueSnapshot(const std::string& path)
+        : file_(std::make_shared<const MappedFile>(path)) {
+        const char* data = file_->GetData();
+        const size_t size = file_->GetSize();
+        if (size < sizeof(Header)) {
+            throw binary_io::FormatError("Not a catalogue snapshot: " + path);
+        }
+        header_ = reinterpret_cast<const Header*>(data);
+        if (!std::equal(std::begin(kSnapshotMagic), std::end(kSnapshotMagic), header_->magic)) {
+            throw binary_io::FormatError("Not a catalogue snapshot: " + path);
+        }
+        if (header_->version != kSnapshotVersion) {
+            throw binary_io::FormatError("Unsupported catalogue snapshot version: " + path);
+        }
+        if (header_->byte_order != kByteOrderMark) {
+            throw binary_io::FormatError("Catalogue snapshot has a different byte order: " + path);
+        }
+
+        // проверяются только границы массивов, сами записи читаются по мере обращения
+        auto section = [&](const Section& s, size_t element_size, size_t alignment) {
+            if (s.offset % alignment != 0 || s.offset > size || s.count > (size - s.offset) / element_size) {
+                throw binary_io::FormatError("Corrupted catalogue snapshot: " + path);
+            }
+            return data + s.offset;
+        };
+        stops_ = { reinterpret_cast<const StopRecord*>(section(header_->stops, sizeof(StopRecord), alignof(StopRecord))),
+            static_cast<size_t>(header_->stops.count) };
+        buses_ = { reinterpret_cast<const BusRecord*>(section(header_->buses, sizeof(BusRecord), alignof(BusRecord))),
+            static_cast<size_t>(header_->buses.count) };
+        route_ = { reinterpret_cast<const uint32_t*>(section(header_->route, sizeof(uint32_t), alignof(uint32_t))),
+            static_cast<size_t>(header_->route.count) };
+        stop_bus_ = { reinterpret_cast<const uint32_t*>(section(header_->stop_bus, sizeof(uint32_t), alignof(uint32_t))),
+            static_cast<size_t>(header_->stop_bus.count) };
+        distances_ = { reinterpret_cast<const DistanceRecord*>(section(header_->distances, sizeof(DistanceRecord), alignof(DistanceRecord))),
+            static_cast<size_t>(header_->distances.count) };
+        pool_ = { section(header_->pool, 1, 1), static_cast<size_t>(header_->pool.count) };
+    }
+
+    std::optional<uint32_t> CatalogueSnapshot::FindStop(std::string_view name) const {
+        auto it = std::lower_bound(stops_.begin(), stops_.end(), name, [this](const StopRecord& stop, std::string_view value) {
+            return GetString(stop.name) < value;
+        });
+        if (it == stops_.end() || GetString(it->name) != name) {
+            return std::nullopt;
+        }
+        return static_cast<uint32_t>(it - stops_.begin());
+    }
+
+    std::optional<uint32_t> CatalogueSnapshot::FindBus(std::string_view number) const {
+        auto it = std::lower_bound(buses_.begin(), buses_.end(), number, [this](const BusRecord& bus, std::string_view value) {
+            return GetString(bus.name) < value;
+        });
+        if (it == buses_.end() || GetString(it->name) != number) {
+            return std::nullopt;
+        }
+        return static_cast<uint32_t>(it - buses_.begin());
+    }
+
+    std::string_view CatalogueSnapshot::GetStopName(uint32_t stop) const {
+        return GetString(stops_[stop].name);
+    }
+
+    std::string_view CatalogueSnapshot::GetBusName(uint32_t bus) const {
+        return GetString(buses_[bus].name);
+    }
+
+    std::span<const uint32_t> CatalogueSnapshot::GetStopBuses(uint32_t stop) const {
+        const StopRecord& record = stops_[stop];
+        if (record.buses_begin > record.buses_end || record.buses_end > stop_bus_.size()) {
+            throw binary_io::FormatError("Corrupted stop record in catalogue snapshot");
+        }
+        std::span<const uint32_t> ids = stop_bus_.subspan(record.buses_begin, record.buses_end - record.buses_begin);
+        for (uint32_t bus : ids) {
+            if (bus >= buses_.size()) {
+                throw binary_io::FormatError("Corrupted stop record in catalogue snapshot");
+            }
+        }
+        return ids;
+    }
+
+    std::span<const uint32_t> CatalogueSnapshot::GetRoute(uint32_t bus) const {
+        const BusRecord& record = buses_[bus];
+        if (record.stops_begin > record.stops_end || record.stops_end > route_.size()) {
+            throw binary_io::FormatError("Corrupted bus record in catalogue snapshot");
+        }
+        std::span<const uint32_t> ids = route_.subspan(record.stops_begin, record.stops_end - record.stops_begin);
+        for (uint32_t stop : ids) {
+            if (stop >= stops_.size()) {
+                throw binary_io::FormatError("Corrupted bus record in catalogue snapshot");
+            }
+        }
+        return ids;
+    }
+
+    // повторяет CalculateRoadLength/CalculateGeoLength/Count* каталога в том же порядке сложения
+    TransportCatalogue::BusStats CatalogueSnapshot::GetBusStats(uint32_t bus) const {
+        std::span<const uint32_t> route = GetRoute(bus);
+        const bool is_ring = buses_[bus].is_ring != 0;
+
+        auto geo_distance = [this](uint32_t from, uint32_t to) {
+            return geo::ComputeDistance({ stops_[from].latitude, stops_[from].longitude },
+                { stops_[to].latitude, stops_[to].longitude });
+        };
+
+        double road_length = 0.0;
+        double geo_length = 0.0;
+        for (size_t i = 0; i + 1 < route.size(); ++i) {
+            road_length += GetRoadDistance(route[i], route[i + 1]);
+            geo_length += geo_distance(route[i], route[i + 1]);
+        }
+        if (!is_ring && route.size() > 1) {
+            for (size_t i = route.size() - 1; i > 0; --i) {
+                road_length += GetRoadDistance(route[i], route[i - 1]);
+                geo_length += geo_distance(route[i], route[i - 1]);
+            }
+        }
+
+        std::vector<uint32_t> unique(route.begin(), route.end());
+        std::sort(unique.begin(), unique.end());
+        size_t unique_stops = static_cast<size_t>(std::unique(unique.begin(), unique.end()) - unique.begin());
+
+        size_t stops_on_route = route.size();
+        if (!is_ring && route.size() > 1) {
+            stops_on_route = route.size() * 2 - 1;
+        }
+
+        double curvature = 0.0;
+        if (geo_length > 1e-6) {
+            curvature = road_length / geo_length;
+        }
+        return { stops_on_route, unique_stops, road_length, curvature };
+    }
+
+    int CatalogueSnapshot::GetRoadDistance(uint32_t from, uint32_t to) const {
+        auto find = [this](uint32_t a, uint32_t b) -> const DistanceRecord* {
+            auto it = std::lower_bound(distances_.begin(), distances_.end(), std::pair(a, b),
+                [](const DistanceRecord& record, std::pair<uint32_t, uint32_t> key) {
+                    return std::pair(record.from, record.to) < key;
+                });
+            if (it == distances_.end() || it->from != a || it->to != b) {
+                return nullptr;
+            }
+            return &*it;
+        };
+        if (const DistanceRecord* record = find(from, to)) {
+            return static_cast<int>(record->distance);
+        }
+        if (const DistanceRecord* record = find(to, from)) {
+            return static_cast<int>(record->distance);
+        }
+        return 0;
+    }
+
+    std::string_view CatalogueSnapshot::GetMap() const {
+        return GetString(header_->map);
+    }
+
+    double CatalogueSnapshot::GetWaitTime() const {
+        return header_->wait_time;
+    }
+
+    double CatalogueSnapshot::GetVelocity() const {
+        return header_->velocity;
+    }
+
+    std::string_view CatalogueSnapshot::GetString(StringRef ref) const {
+        if (ref.offset > pool_.size() || ref.length > pool_.size() - ref.offset) {
+            throw binary_io::FormatError("Corrupted string in catalogue snapshot");
+        }
+        return pool_.substr(ref.offset, ref.length);
+    }
+
+} // namespace transport
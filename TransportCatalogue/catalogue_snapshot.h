@@ -0,0 +1,93 @@
+#pragma once
+#include "mapped_file.h"
+#include "transport_catalogue.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace transport {
+
+    // Плоский снимок TransportCatalogue для чтения без разбора в unordered_map.
+    // Файл отображается в память только на чтение (MappedFile), поэтому несколько
+    // процессов с одним снимком делят одну физическую копию.
+    //
+    // Раскладка: заголовок, затем массивы фиксированных записей, выровненные по 8 байт:
+    //   stops     - StopRecord, отсортированы по имени, номер остановки = позиция;
+    //   buses     - BusRecord, отсортированы по номеру;
+    //   route     - номера остановок всех маршрутов подряд;
+    //   stop_bus  - номера автобусов через остановку, по возрастанию (= по имени);
+    //   distances - DistanceRecord, отсортированы по (from, to);
+    //   pool      - байты всех строк, включая готовый SVG карты.
+    // Индексы внутри записей проверяются при обращении, ошибка - binary_io::FormatError.
+    class CatalogueSnapshot {
+    public:
+        struct StringRef {
+            uint32_t offset;
+            uint32_t length;
+        };
+        struct StopRecord {
+            StringRef name;
+            uint32_t buses_begin;// диапазон в stop_bus
+            uint32_t buses_end;
+            double latitude;
+            double longitude;
+        };
+        struct BusRecord {
+            StringRef name;
+            uint32_t stops_begin;// диапазон в route
+            uint32_t stops_end;
+            uint32_t is_ring;
+            uint32_t reserved;
+        };
+        struct DistanceRecord {
+            uint32_t from;
+            uint32_t to;
+            double distance;
+        };
+
+        // Пишет снимок каталога и уже отрисованной карты в path.
+        // Маршрут с неизвестной остановкой - std::runtime_error
+        static void Write(const TransportCatalogue& tc, std::string_view map_svg, const std::string& path);
+
+        explicit CatalogueSnapshot(const std::string& path);
+
+        size_t GetStopCount() const {
+            return stops_.size();
+        }
+        size_t GetBusCount() const {
+            return buses_.size();
+        }
+        std::optional<uint32_t> FindStop(std::string_view name) const;
+        std::optional<uint32_t> FindBus(std::string_view number) const;
+        std::string_view GetStopName(uint32_t stop) const;
+        std::string_view GetBusName(uint32_t bus) const;
+        // номера автобусов через остановку, в порядке их имен
+        std::span<const uint32_t> GetStopBuses(uint32_t stop) const;
+        // та же статистика, что TransportCatalogue::GetBusInfo
+        TransportCatalogue::BusStats GetBusStats(uint32_t bus) const;
+        int GetRoadDistance(uint32_t from, uint32_t to) const;
+
+        std::string_view GetMap() const;
+        double GetWaitTime() const;
+        double GetVelocity() const;
+    private:
+        struct Header;
+
+        std::string_view GetString(StringRef ref) const;
+        std::span<const uint32_t> GetRoute(uint32_t bus) const;
+
+        std::shared_ptr<const MappedFile> file_;
+        const Header* header_ = nullptr;
+        std::span<const StopRecord> stops_;
+        std::span<const BusRecord> buses_;
+        std::span<const uint32_t> route_;
+        std::span<const uint32_t> stop_bus_;
+        std::span<const DistanceRecord> distances_;
+        std::string_view pool_;
+    };
+
+} // namespace transport
@@ -0,0 +1,253 @@
+#include "connection_scan.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace {
+    // Рабочие массивы одного запроса: прибытие в остановки и посадки в рейсы.
+    // Как в SearchWorkspace, значение действительно только при отметке текущей эпохи,
+    // поэтому запрос не чистит массивы размером в остановки и рейсы всего дня -
+    // трогаются лишь те, что встретились при проходе. Живут в своем потоке.
+    class ScanWorkspace {
+    public:
+        static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+        static ScanWorkspace& ForThread(size_t stop_count, size_t trip_count) {
+            thread_local ScanWorkspace workspace;
+            workspace.Begin(stop_count, trip_count);
+            return workspace;
+        }
+
+        double Arrival(size_t stop) const {
+            return stops_[stop].epoch == epoch_ ? stops_[stop].arrival : std::numeric_limits<double>::infinity();
+        }
+        uint32_t ArrivedBy(size_t stop) const {
+            return stops_[stop].epoch == epoch_ ? stops_[stop].arrived_by : kNone;
+        }
+        void SetArrival(size_t stop, double arrival, uint32_t arrived_by) {
+            stops_[stop] = StopSlot{ arrival, epoch_, arrived_by };
+        }
+        uint32_t BoardedAt(size_t trip) const {
+            return trips_[trip].epoch == epoch_ ? trips_[trip].boarded_at : kNone;
+        }
+        void SetBoardedAt(size_t trip, uint32_t connection) {
+            trips_[trip] = TripSlot{ epoch_, connection };
+        }
+    private:
+        struct StopSlot {
+            double arrival;
+            uint32_t epoch;
+            uint32_t arrived_by;// связь, которой пришли в остановку
+        };
+        struct TripSlot {
+            uint32_t epoch;
+            uint32_t boarded_at;// связь, на которой сели в рейс
+        };
+
+        void Begin(size_t stop_count, size_t trip_count) {
+            if (++epoch_ == 0) {
+                // счетчик обошел круг: старые отметки могли бы совпасть с новыми
+                std::fill(stops_.begin(), stops_.end(), StopSlot{ 0.0, 0, kNone });
+                std::fill(trips_.begin(), trips_.end(), TripSlot{ 0, kNone });
+                epoch_ = 1;
+            }
+            if (stops_.size() < stop_count) {
+                stops_.resize(stop_count, StopSlot{ 0.0, 0, kNone });
+            }
+            if (trips_.size() < trip_count) {
+                trips_.resize(trip_count, TripSlot{ 0, kNone });
+            }
+        }
+
+        uint32_t epoch_ = 0;
+        std::vector<StopSlot> stops_;
+        std::vector<TripSlot> trips_;
+    };
+}
+
+void ConnectionScanRouter::Build(const transport::TransportCatalogue& tc, const Graph& graph) {
+    stop_count_ = graph.GetStopCount();
+    speed_m_per_min_ = EdgeWeights::SpeedFromVelocity(tc.GetVelocity());
+    connections_.clear();
+    trip_bus_.clear();
+    trip_start_.clear();
+    trip_first_.clear();
+    stop_distance_.clear();
+
+    // номера автобусов графа после UpdateEdges не совпадают с порядком каталога, берем по имени
+    std::unordered_map<std::string_view, uint32_t> bus_to_index;
+    for (size_t id = 0; id < graph.GetBusCount(); ++id) {
+        bus_to_index[graph.GetBusName(id)] = static_cast<uint32_t>(id);
+    }
+    for (const auto& [bus_name, bus] : *tc.GetBuses()) {
+        if (bus.departures.empty() || bus.route.size() < 2) {
+            continue;
+        }
+        const uint32_t bus_id = bus_to_index.at(bus_name);
+        AddTrips(tc, graph, bus_id, bus, false);
+        if (!bus.is_ring) {
+            AddTrips(tc, graph, bus_id, bus, true);
+        }
+    }
+
+    SetConnectionTimes();
+    SortConnections();
+}
+
+void ConnectionScanRouter::SetSpeed(double speed_m_per_min) {
+    if (speed_m_per_min == speed_m_per_min_) {
+        return;
+    }
+    speed_m_per_min_ = speed_m_per_min;
+    SetConnectionTimes();
+    SortConnections();
+}
+
+void ConnectionScanRouter::SetConnectionTimes() {
+    // то же выражение, что при построении с этой скоростью, поэтому время совпадает до бита
+    for (Connection& c : connections_) {
+        const double start = trip_start_[c.trip];
+        const double* distance = stop_distance_.data() + trip_first_[c.trip] + c.position;
+        c.departure = start + distance[0] / speed_m_per_min_;
+        c.arrival = start + distance[1] / speed_m_per_min_;
+    }
+}
+
+void ConnectionScanRouter::SortConnections() {
+    // при равном отправлении раньше идет более ранний перегон рейса: на него
+    // должна попасть посадка, иначе следующий перегон не увидит рейс
+    std::sort(connections_.begin(), connections_.end(), [](const Connection& lhs, const Connection& rhs) {
+        if (lhs.departure != rhs.departure) {
+            return lhs.departure < rhs.departure;
+        }
+        if (lhs.trip != rhs.trip) {
+            return lhs.trip < rhs.trip;
+        }
+        return lhs.position < rhs.position;
+    });
+}
+
+void ConnectionScanRouter::AddTrips(const transport::TransportCatalogue& tc, const Graph& graph,
+    uint32_t bus_id, const transport::Bus& bus, bool reverse) {
+    const auto& route = bus.route;
+    const auto& stop_to_index = graph.GetStopToIndex();
+
+    // расстояние от первой остановки рейса до каждой следующей, общее для всех рейсов
+    const uint32_t first = static_cast<uint32_t>(stop_distance_.size());
+    std::vector<uint32_t> stops;
+    double distance = 0.0;
+    for (size_t pos = 0; pos < route.size(); ++pos) {
+        size_t idx = reverse ? route.size() - 1 - pos : pos;
+        if (pos > 0) {
+            size_t prev_idx = reverse ? idx + 1 : idx - 1;
+            distance += tc.GetRoadDistance(route[prev_idx], route[idx]);
+        }
+        stops.push_back(static_cast<uint32_t>(stop_to_index.at(route[idx])));
+        stop_distance_.push_back(distance);
+    }
+
+    for (double start : bus.departures) {
+        const uint32_t trip = static_cast<uint32_t>(trip_bus_.size());
+        trip_bus_.push_back(bus_id);
+        trip_start_.push_back(start);
+        trip_first_.push_back(first);
+        // время проставит SetConnectionTimes
+        for (size_t pos = 0; pos + 1 < stops.size(); ++pos) {
+            connections_.push_back(Connection{ 0.0, 0.0,
+                stops[pos], stops[pos + 1], trip, static_cast<uint32_t>(pos) });
+        }
+    }
+}
+
+std::optional<ConnectionScanRouter::Journey> ConnectionScanRouter::FindJourney(size_t from_stop, size_t to_stop,
+    double departure_time) const {
+    const double INF = std::numeric_limits<double>::infinity();
+    ScanWorkspace& workspace = ScanWorkspace::ForThread(stop_count_, trip_bus_.size());
+    workspace.SetArrival(from_stop, departure_time, kNone);
+
+    auto first = std::lower_bound(connections_.begin(), connections_.end(), departure_time,
+        [](const Connection& c, double time) {
+            return c.departure < time;
+        });
+    double target_arrival = workspace.Arrival(to_stop);
+    for (auto it = first; it != connections_.end(); ++it) {
+        const Connection& c = *it;
+        if (c.departure >= target_arrival) {
+            break;
+        }
+        if (workspace.BoardedAt(c.trip) == kNone) {
+            if (workspace.Arrival(c.from_stop) > c.departure) {
+                continue;
+            }
+            workspace.SetBoardedAt(c.trip, static_cast<uint32_t>(it - connections_.begin()));
+        }
+        if (c.arrival < workspace.Arrival(c.to_stop)) {
+            workspace.SetArrival(c.to_stop, c.arrival, static_cast<uint32_t>(it - connections_.begin()));
+            if (c.to_stop == to_stop) {
+                target_arrival = c.arrival;
+            }
+        }
+    }
+    if (target_arrival == INF) {
+        return std::nullopt;
+    }
+
+    Journey journey;
+    journey.arrival = target_arrival;
+    size_t stop = to_stop;
+    // каждая поездка уходит не позже прибытия в следующую, так что ног не больше остановок.
+    // Цепочка, которая обрывается или не доходит до from_stop за это число ног, - не маршрут:
+    // обрезанный путь выглядел бы правдоподобно, поэтому вместо него nullopt
+    while (stop != from_stop) {
+        const uint32_t alight_id = workspace.ArrivedBy(stop);
+        if (alight_id == kNone || journey.legs.size() >= stop_count_) {
+            return std::nullopt;
+        }
+        const Connection& alight = connections_[alight_id];
+        const uint32_t board_id = workspace.BoardedAt(alight.trip);
+        if (board_id == kNone) {
+            return std::nullopt;
+        }
+        const Connection& board = connections_[board_id];
+        journey.legs.push_back(Leg{ board.from_stop, trip_bus_[alight.trip], alight.position - board.position + 1,
+            board.departure - workspace.Arrival(board.from_stop), alight.arrival - board.departure });
+        stop = board.from_stop;
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+void ConnectionScanRouter::Serialize(binary_io::Writer& writer) const {
+    writer.Write(speed_m_per_min_);
+    writer.WriteVector(trip_bus_);
+    writer.WriteVector(trip_start_);
+    writer.WriteVector(trip_first_);
+    writer.WriteVector(stop_distance_);
+    writer.WriteVector(connections_);
+}
+
+void ConnectionScanRouter::Deserialize(binary_io::Reader& reader, size_t stop_count, size_t bus_count) {
+    stop_count_ = stop_count;
+    speed_m_per_min_ = reader.Read<double>();
+    trip_bus_ = reader.ReadVector<uint32_t>();
+    trip_start_ = reader.ReadVector<double>();
+    trip_first_ = reader.ReadVector<uint32_t>();
+    stop_distance_ = reader.ReadVector<double>();
+    connections_ = reader.ReadVector<Connection>();
+    if (!(speed_m_per_min_ > 0.0) || trip_start_.size() != trip_bus_.size() || trip_first_.size() != trip_bus_.size()) {
+        throw binary_io::FormatError("Timetable trips are inconsistent");
+    }
+    for (uint32_t bus_id : trip_bus_) {
+        if (bus_id >= bus_count) {
+            throw binary_io::FormatError("Timetable trip refers to an unknown bus");
+        }
+    }
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        const Connection& c = connections_[i];
+        if (c.from_stop >= stop_count || c.to_stop >= stop_count || c.trip >= trip_bus_.size()
+            || static_cast<size_t>(trip_first_[c.trip]) + c.position + 1 >= stop_distance_.size()
+            || (i > 0 && c.departure < connections_[i - 1].departure)) {
+            throw binary_io::FormatError("Timetable connection is out of range");
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "binary_io.h"
+#include "graph.h"
+#include "transport_catalogue.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Поиск по расписанию (Connection Scan): каждый перегон каждого рейса - связь
+// (отправление, прибытие, откуда, куда, рейс), все связи лежат одним массивом по
+// времени отправления. Запрос - один линейный проход от первой связи не раньше
+// момента отправления до первой, уходящей позже уже найденного прибытия в цель.
+// Ожидание на остановке - реальное время до отправления рейса, а не bus_wait_time.
+// В поиске участвуют только автобусы с расписанием (Bus::departures).
+// Время в пути между остановками рейса - расстояние, деленное на скорость, поэтому
+// рядом со связями хранятся расстояния, и SetSpeed пересчитывает связи без каталога.
+class ConnectionScanRouter {
+public:
+    struct Leg {
+        uint32_t board_stop;
+        uint32_t bus_id;
+        uint32_t span_count;
+        double wait_time;
+        double ride_time;
+    };
+
+    struct Journey {
+        double arrival = 0.0;// минуты от начала суток
+        std::vector<Leg> legs;
+    };
+
+    // Индексы остановок и автобусов берутся из graph (см. Graph::BuildStopIndex),
+    // скорость - из настроек каталога
+    void Build(const transport::TransportCatalogue& tc, const Graph& graph);
+
+    double GetSpeed() const {
+        return speed_m_per_min_;
+    }
+    // Новая скорость, м/мин: время связей пересчитывается, массив заново сортируется
+    void SetSpeed(double speed_m_per_min);
+
+    bool Empty() const {
+        return connections_.empty();
+    }
+    size_t GetConnectionCount() const {
+        return connections_.size();
+    }
+    // Самое раннее прибытие в to_stop при отправлении из from_stop не раньше departure_time
+    std::optional<Journey> FindJourney(size_t from_stop, size_t to_stop, double departure_time) const;
+
+    void Serialize(binary_io::Writer& writer) const;
+    // stop_count и bus_count - из уже загруженного графа, по ним проверяются связи
+    void Deserialize(binary_io::Reader& reader, size_t stop_count, size_t bus_count);
+private:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+    // 32 байта, чтобы проход по массиву читал связи целыми строками кэша
+    struct Connection {
+        double departure;
+        double arrival;
+        uint32_t from_stop;
+        uint32_t to_stop;
+        uint32_t trip;
+        uint32_t position;// номер перегона в рейсе, по нему считается span_count
+    };
+
+    void AddTrips(const transport::TransportCatalogue& tc, const Graph& graph,
+        uint32_t bus_id, const transport::Bus& bus, bool reverse);
+    // время отправления и прибытия связей по trip_start_ и расстояниям при speed_m_per_min_
+    void SetConnectionTimes();
+    void SortConnections();
+
+    size_t stop_count_ = 0;
+    double speed_m_per_min_ = 1.0;
+    std::vector<Connection> connections_;// по возрастанию departure
+    std::vector<uint32_t> trip_bus_;     // рейс -> номер автобуса
+    std::vector<double> trip_start_;     // рейс -> отправление с первой остановки
+    std::vector<uint32_t> trip_first_;   // рейс -> начало его расстояний в stop_distance_
+    // расстояние от первой остановки направления до каждой следующей, м;
+    // рейсы одного направления автобуса делят одну строку
+    std::vector<double> stop_distance_;
+};
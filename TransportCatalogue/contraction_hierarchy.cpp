@@ -0,0 +1,369 @@
+#include "contraction_hierarchy.h"
+#include "search_workspace.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <utility>
+
+namespace {
+    using PQItem = std::pair<double, uint32_t>;
+    constexpr uint32_t kNoEdge = std::numeric_limits<uint32_t>::max();
+    // сколько вершин может осесть в поиске свидетеля; если свидетель не найден
+    // в этих пределах, добавляется лишний, но корректный shortcut.
+    // Для оценки приоритета хватает свидетелей из одного-двух ребер
+    constexpr size_t kSimulateSettleLimit = 0;
+    constexpr size_t kContractSettleLimit = 30;
+
+    struct Arc {
+        uint32_t other;
+        uint32_t edge;
+    };
+
+    // Локальная Дейкстра для поиска свидетелей, сбрасывает только тронутые вершины
+    class WitnessSearch {
+    public:
+        explicit WitnessSearch(size_t vertex_count)
+            : dist_(vertex_count, std::numeric_limits<double>::infinity()) {
+        }
+
+        // is_target[v] == 1 для вершин, до которых ищем свидетеля; поиск
+        // заканчивается, когда все они осели
+        template <typename OutArcs>
+        void Run(uint32_t source, uint32_t skip, double max_dist, size_t settle_limit, size_t target_count,
+            const std::vector<char>& is_target, const std::vector<char>& contracted,
+            const OutArcs& out, const std::vector<double>& weights) {
+            Reset();
+            Touch(source, 0.0);
+            heap_.push_back({ 0.0, source });
+            size_t settled = 0;
+            while (!heap_.empty() && settled < settle_limit && target_count > 0) {
+                std::pop_heap(heap_.begin(), heap_.end(), std::greater<PQItem>{});
+                auto [d, v] = heap_.back();
+                heap_.pop_back();
+                if (d > dist_[v]) continue;
+                if (d > max_dist) break;
+                ++settled;
+                if (is_target[v] == 1) --target_count;
+                // дуги отсортированы по весу, дальше только длиннее max_dist
+                for (const Arc& arc : out[v]) {
+                    double nd = d + weights[arc.edge];
+                    if (nd > max_dist) break;
+                    if (arc.other == skip || contracted[arc.other]) continue;
+                    if (nd < dist_[arc.other]) {
+                        Touch(arc.other, nd);
+                        heap_.push_back({ nd, arc.other });
+                        std::push_heap(heap_.begin(), heap_.end(), std::greater<PQItem>{});
+                    }
+                }
+            }
+        }
+        double Dist(uint32_t v) const {
+            return dist_[v];
+        }
+    private:
+        void Touch(uint32_t v, double d) {
+            if (dist_[v] == std::numeric_limits<double>::infinity()) {
+                touched_.push_back(v);
+            }
+            dist_[v] = d;
+        }
+        void Reset() {
+            for (uint32_t v : touched_) {
+                dist_[v] = std::numeric_limits<double>::infinity();
+            }
+            touched_.clear();
+            heap_.clear();
+        }
+
+        std::vector<double> dist_;
+        std::vector<uint32_t> touched_;
+        std::vector<PQItem> heap_;
+    };
+}
+
+void ContractionHierarchy::Build(const Graph& graph) {
+    const uint32_t n = static_cast<uint32_t>(graph.GetVertexCount());
+    edges_.clear();
+    shortcut_count_ = 0;
+    std::vector<double> weights;// дублирует edges_[e].weight для поиска свидетелей
+    std::vector<std::vector<Arc>> out(n);
+    std::vector<std::vector<Arc>> in(n);
+
+    // исходные ребра; из параллельных остается самое легкое
+    std::vector<uint32_t> arc_to(n, kNoEdge);
+    for (uint32_t v = 0; v < n; ++v) {
+        for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+            uint32_t to = static_cast<uint32_t>(graph.GetEdgeTarget(edge_id));
+            double weight = graph.GetEdgeWeight(edge_id);
+            if (to == v) continue;
+            if (arc_to[to] != kNoEdge) {
+                Edge& existing = edges_[out[v][arc_to[to]].edge];
+                if (weight < existing.weight) {
+                    existing.weight = weight;
+                    existing.original = static_cast<uint32_t>(edge_id);
+                    weights[out[v][arc_to[to]].edge] = weight;
+                }
+                continue;
+            }
+            uint32_t id = static_cast<uint32_t>(edges_.size());
+            edges_.push_back(Edge{ v, to, weight, static_cast<uint32_t>(edge_id), kNone, kNone });
+            weights.push_back(weight);
+            arc_to[to] = static_cast<uint32_t>(out[v].size());
+            out[v].push_back(Arc{ to, id });
+            in[to].push_back(Arc{ v, id });
+        }
+        for (const Arc& arc : out[v]) {
+            arc_to[arc.other] = kNoEdge;
+        }
+    }
+    // исходящие дуги держим по возрастанию веса, чтобы поиск свидетеля обрывал перебор
+    auto lighter = [&](const Arc& lhs, const Arc& rhs) {
+        return weights[lhs.edge] < weights[rhs.edge];
+    };
+    for (auto& arcs : out) {
+        std::sort(arcs.begin(), arcs.end(), lighter);
+    }
+
+    std::vector<char> contracted(n, 0);
+    std::vector<int> deleted_neighbors(n, 0);
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<char> has_other_in(n, 0);
+    std::vector<char> pending(n, 0);// 1 - цель поиска свидетеля, 2 - свидетель из двух ребер
+    std::vector<double> direct(n, INF);// вес ребра u -> x для текущего u
+    WitnessSearch witness(n);
+
+    // обходит shortcut-ы, нужные при сжатии v; add(u, x, weight, in_edge, out_edge)
+    auto for_each_shortcut = [&](uint32_t v, size_t settle_limit, auto&& add) {
+        // свидетель возможен, только если в x входит что-то кроме v
+        // (у board-вершины до сжатия соседей вход один - из своей wait)
+        double max_out = 0.0;
+        for (const Arc& arc : out[v]) {
+            if (contracted[arc.other]) continue;
+            max_out = std::max(max_out, weights[arc.edge]);
+            for (const Arc& back : in[arc.other]) {
+                if (back.other != v && !contracted[back.other]) {
+                    has_other_in[arc.other] = 1;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < in[v].size(); ++i) {
+            const Arc in_arc = in[v][i];
+            uint32_t u = in_arc.other;
+            if (contracted[u]) continue;
+            double w_uv = weights[in_arc.edge];
+            // свидетель из одного ребра u -> x - частый случай, когда u и x на одном автобусе
+            for (const Arc& arc : out[u]) {
+                direct[arc.other] = weights[arc.edge];
+            }
+            size_t pending_count = 0;
+            for (const Arc& out_arc : out[v]) {
+                uint32_t x = out_arc.other;
+                if (contracted[x] || x == u || !has_other_in[x]) continue;
+                double total = w_uv + weights[out_arc.edge];
+                if (direct[x] <= total) continue;
+                // свидетель из двух ребер u -> y -> x
+                bool two_hops = false;
+                for (const Arc& back : in[x]) {
+                    if (back.other != v && !contracted[back.other]
+                        && direct[back.other] + weights[back.edge] <= total) {
+                        two_hops = true;
+                        break;
+                    }
+                }
+                if (two_hops) {
+                    pending[x] = 2;
+                    continue;
+                }
+                pending[x] = 1;
+                ++pending_count;
+            }
+            if (pending_count > 0 && settle_limit > 0) {
+                witness.Run(u, v, w_uv + max_out, settle_limit, pending_count, pending, contracted, out, weights);
+            }
+            for (size_t j = 0; j < out[v].size(); ++j) {
+                const Arc out_arc = out[v][j];
+                uint32_t x = out_arc.other;
+                if (contracted[x] || x == u) continue;
+                double total = w_uv + weights[out_arc.edge];
+                bool has_witness = has_other_in[x] && (direct[x] <= total || pending[x] == 2
+                    || (pending[x] == 1 && settle_limit > 0 && witness.Dist(x) <= total));
+                if (!has_witness) {
+                    add(u, x, total, in_arc.edge, out_arc.edge);
+                }
+            }
+            for (const Arc& out_arc : out[v]) {
+                pending[out_arc.other] = 0;
+            }
+            for (const Arc& arc : out[u]) {
+                direct[arc.other] = INF;
+            }
+        }
+        for (const Arc& arc : out[v]) {
+            has_other_in[arc.other] = 0;
+        }
+    };
+    auto priority = [&](uint32_t v) {
+        int shortcuts = 0;
+        for_each_shortcut(v, kSimulateSettleLimit, [&](uint32_t, uint32_t, double, uint32_t, uint32_t) {
+            ++shortcuts;
+        });
+        int degree = 0;
+        for (const Arc& arc : in[v]) degree += !contracted[arc.other];
+        for (const Arc& arc : out[v]) degree += !contracted[arc.other];
+        return shortcuts - degree + deleted_neighbors[v];
+    };
+    auto add_shortcut = [&](uint32_t u, uint32_t x, double weight, uint32_t first, uint32_t second) {
+        uint32_t id = static_cast<uint32_t>(edges_.size());
+        auto existing = std::find_if(out[u].begin(), out[u].end(), [x](const Arc& arc) {
+            return arc.other == x;
+        });
+        if (existing != out[u].end()) {
+            if (weights[existing->edge] <= weight) return;
+            // заменяем ребро u -> x более легким shortcut-ом
+            for (Arc& back : in[x]) {
+                if (back.edge == existing->edge) back.edge = id;
+            }
+            out[u].erase(existing);
+        }
+        else {
+            in[x].push_back(Arc{ u, id });
+        }
+        edges_.push_back(Edge{ u, x, weight, kNone, first, second });
+        weights.push_back(weight);
+        ++shortcut_count_;
+        Arc arc{ x, id };
+        out[u].insert(std::upper_bound(out[u].begin(), out[u].end(), arc, lighter), arc);
+    };
+
+    // ленивая очередь: перед сжатием приоритет пересчитывается
+    std::vector<std::pair<int, uint32_t>> queue;
+    queue.reserve(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        queue.push_back({ priority(v), v });
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<>{});
+
+    rank_.assign(n, 0);
+    std::vector<std::vector<uint32_t>> up_lists(n);
+    std::vector<std::vector<uint32_t>> down_lists(n);
+    uint32_t next_rank = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+        uint32_t v = queue.back().second;
+        queue.pop_back();
+        int current = priority(v);
+        if (!queue.empty() && current > queue.front().first) {
+            queue.push_back({ current, v });
+            std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+            continue;
+        }
+        for_each_shortcut(v, kContractSettleLimit, add_shortcut);
+        contracted[v] = 1;
+        rank_[v] = next_rank++;
+        // все оставшиеся соседи v выше по рангу: исходящие ребра v идут в поиск
+        // вверх, входящие - в обратный поиск; из списков соседей v убираем
+        for (const Arc& arc : out[v]) {
+            up_lists[v].push_back(arc.edge);
+            auto& back = in[arc.other];
+            back.erase(std::find_if(back.begin(), back.end(), [v](const Arc& a) { return a.other == v; }));
+            ++deleted_neighbors[arc.other];
+        }
+        for (const Arc& arc : in[v]) {
+            down_lists[v].push_back(arc.edge);
+            auto& forward = out[arc.other];
+            forward.erase(std::find_if(forward.begin(), forward.end(), [v](const Arc& a) { return a.other == v; }));
+            ++deleted_neighbors[arc.other];
+        }
+        std::vector<Arc>().swap(out[v]);
+        std::vector<Arc>().swap(in[v]);
+    }
+
+    up_offsets_.assign(n + 1, 0);
+    down_offsets_.assign(n + 1, 0);
+    up_edges_.clear();
+    down_edges_.clear();
+    for (uint32_t v = 0; v < n; ++v) {
+        up_edges_.insert(up_edges_.end(), up_lists[v].begin(), up_lists[v].end());
+        down_edges_.insert(down_edges_.end(), down_lists[v].begin(), down_lists[v].end());
+        up_offsets_[v + 1] = static_cast<uint32_t>(up_edges_.size());
+        down_offsets_[v + 1] = static_cast<uint32_t>(down_edges_.size());
+    }
+}
+
+double ContractionHierarchy::FindPath(size_t source, size_t target, std::vector<size_t>& path_edges) const {
+    const double INF = std::numeric_limits<double>::infinity();
+    path_edges.clear();
+    if (source == target) {
+        return 0.0;
+    }
+
+    // стороны поиска берут массивы из пула потока, между запросами они не чистятся
+    const size_t n = rank_.size();
+    SearchWorkspace::Lease side_search[2] = { SearchWorkspace::Borrow(n), SearchWorkspace::Borrow(n) };
+    side_search[0]->Set(source, 0.0, kNoEdge);
+    side_search[1]->Set(target, 0.0, kNoEdge);
+    side_search[0]->Queue().Push(0.0, source);
+    side_search[1]->Queue().Push(0.0, target);
+
+    double best = INF;
+    uint32_t meet = kNoEdge;
+    for (int side = 0; !side_search[0]->Queue().Empty() || !side_search[1]->Queue().Empty(); side ^= 1) {
+        SearchWorkspace& search = *side_search[side];
+        const SearchWorkspace& other = *side_search[side ^ 1];
+        LazyBinaryHeap& h = search.Queue();
+        if (h.Empty()) continue;
+        auto [d, v] = h.Pop();
+        if (d > search.Dist(v)) continue;
+        if (d >= best) {
+            h.Reset(n);// вверх дальше только длиннее
+            continue;
+        }
+        if (other.Dist(v) < INF && d + other.Dist(v) < best) {
+            best = d + other.Dist(v);
+            meet = static_cast<uint32_t>(v);
+        }
+        const auto& offsets = side == 0 ? up_offsets_ : down_offsets_;
+        const auto& list = side == 0 ? up_edges_ : down_edges_;
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const Edge& e = edges_[list[i]];
+            uint32_t next = side == 0 ? e.to : e.from;
+            double nd = d + e.weight;
+            if (nd < search.Dist(next)) {
+                search.Set(next, nd, list[i]);
+                h.Push(nd, next);
+            }
+        }
+    }
+
+    if (meet == kNoEdge) {
+        return INF;
+    }
+    std::vector<uint32_t> up_path;
+    for (uint32_t v = meet; side_search[0]->PrevEdge(v) != kNoEdge; v = edges_[side_search[0]->PrevEdge(v)].from) {
+        up_path.push_back(side_search[0]->PrevEdge(v));
+    }
+    std::reverse(up_path.begin(), up_path.end());
+    for (uint32_t v = meet; side_search[1]->PrevEdge(v) != kNoEdge; v = edges_[side_search[1]->PrevEdge(v)].to) {
+        up_path.push_back(side_search[1]->PrevEdge(v));
+    }
+    for (uint32_t edge_id : up_path) {
+        Unpack(edge_id, path_edges);
+    }
+    return best;
+}
+
+void ContractionHierarchy::Unpack(uint32_t edge_id, std::vector<size_t>& path_edges) const {
+    std::vector<uint32_t> stack{ edge_id };
+    while (!stack.empty()) {
+        const Edge& e = edges_[stack.back()];
+        stack.pop_back();
+        if (e.original != kNone) {
+            path_edges.push_back(e.original);
+        }
+        else {
+            stack.push_back(e.second_child);
+            stack.push_back(e.first_child);
+        }
+    }
+}
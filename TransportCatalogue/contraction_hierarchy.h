@@ -0,0 +1,46 @@
+#pragma once
+#include "graph.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Иерархия сжатия над Graph. Вершины (и wait, и board) сжимаются по возрастанию
+// важности, вместо каждой сжатой вершины добавляются короткие пути (shortcut-ребра)
+// между ее соседями, если без нее кратчайший путь не сохраняется.
+// Запрос - двунаправленный поиск только вверх по рангу, найденный путь
+// разворачивается обратно в ребра Graph, поэтому Wait/Bus элементы и bus_wait_time
+// остаются такими же, как у обычной Дейкстры.
+class ContractionHierarchy {
+public:
+    void Build(const Graph& graph);
+
+    // Время пути от source до target и ребра Graph в прямом порядке
+    double FindPath(size_t source, size_t target, std::vector<size_t>& path_edges) const;
+
+    size_t GetShortcutCount() const {
+        return shortcut_count_;
+    }
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Edge {
+        uint32_t from;
+        uint32_t to;
+        double weight;
+        uint32_t original;// номер ребра Graph, kNone для shortcut
+        uint32_t first_child;// для shortcut: from -> середина
+        uint32_t second_child;// для shortcut: середина -> to
+    };
+
+    void Unpack(uint32_t edge_id, std::vector<size_t>& path_edges) const;
+
+    std::vector<Edge> edges_;
+    std::vector<uint32_t> rank_;
+    size_t shortcut_count_ = 0;
+    // up: ребра u -> x с rank[u] < rank[x], лежат у u (прямой поиск)
+    std::vector<uint32_t> up_offsets_;
+    std::vector<uint32_t> up_edges_;
+    // down: ребра u -> x с rank[u] > rank[x], лежат у x (обратный поиск идет к u)
+    std::vector<uint32_t> down_offsets_;
+    std::vector<uint32_t> down_edges_;
+};
@@ -1,19 +1,67 @@
 #pragma once
+#include "binary_io.h"
+#include "geo.h"
+#include "mapped_file.h"
 #include "transport_catalogue.h"
+#include "priority_queues.h"
+#include "route_table.h"
+#include "search_workspace.h"
+#include "stop_order.h"
+#include "work_stealing.h"
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
-struct GraphEdge{
-    size_t from;
-    size_t to;
-    double weight;
-    bool is_wait;
-    std::string stop_name;// для wait
-    std::string bus_name;// для bus
-    int span_count; //для bus
+// Атрибуты ребра для восстановления маршрута; имена остановок и автобусов хранятся в Graph один раз
+struct EdgeInfo {
+    static constexpr uint32_t kWait = std::numeric_limits<uint32_t>::max();
+
+    uint32_t bus_id = kWait;// kWait для ребра ожидания
+    uint32_t span_count = 0;//для bus
+
+    bool IsWait() const {
+        return bus_id == kWait;
+    }
+};
+
+// Настройки, из которых выводится время ребра: у ребра ожидания - wait_time,
+// у поездки - расстояние / скорость. Ребра хранят только расстояние, так что
+// другие настройки не требуют перестройки графа
+struct EdgeWeights {
+    double wait_time = 0.0;      // мин
+    double speed_m_per_min = 1.0;// м/мин
+
+    // из routing_settings: ожидание в минутах, скорость в км/ч
+    static EdgeWeights FromSettings(double bus_wait_time, double bus_velocity){
+        return EdgeWeights{ bus_wait_time, SpeedFromVelocity(bus_velocity) };
+    }
+    static double SpeedFromVelocity(double bus_velocity){
+        return bus_velocity * (1000.0 / 60.0);
+    }
+    // то же выражение, что при построении ребер, поэтому время совпадает до бита
+    double Weight(double distance, bool is_wait) const{
+        return is_wait ? wait_time : distance / speed_m_per_min;
+    }
+    bool operator==(const EdgeWeights& other) const = default;
+};
+
+// Дерево кратчайших путей из wait-вершины одной остановки
+struct ShortestPathTree {
+    std::vector<double> dist;   // dist[vertex] = мин время
+    std::vector<int> prev_edge; // prev_edge[vertex] = индекс ребра, по которому пришли
+
+    size_t ByteSize() const {
+        return dist.capacity() * sizeof(double) + prev_edge.capacity() * sizeof(int);
+    }
 };
 
 class Graph{
@@ -21,14 +69,105 @@ public:
     const std::unordered_map<std::string, size_t>& GetStopToIndex() const{
         return stop_to_index_;
     }
-    const std::vector<std::vector<double>>& GetAllDist() const{
-        return all_dist_;
+    const RouteTable& GetRouteTable() const{
+        return route_table_;
+    }
+    size_t GetEdgeCount() const{
+        return targets_.size();
+    }
+    // исходящие ребра вершины v - номера [EdgesBegin(v), EdgesEnd(v))
+    size_t EdgesBegin(size_t v) const{
+        return offsets_[v];
+    }
+    size_t EdgesEnd(size_t v) const{
+        return offsets_[v + 1];
+    }
+    // входящие ребра вершины v - позиции [ReverseEdgesBegin(v), ReverseEdgesEnd(v)) обратного списка
+    size_t ReverseEdgesBegin(size_t v) const{
+        return reverse_offsets_[v];
+    }
+    size_t ReverseEdgesEnd(size_t v) const{
+        return reverse_offsets_[v + 1];
+    }
+    size_t GetReverseEdgeId(size_t pos) const{
+        return reverse_edge_ids_[pos];
+    }
+    size_t GetReverseEdgeSource(size_t pos) const{
+        return reverse_sources_[pos];
+    }
+    bool HasReverseAdjacency() const{
+        return !reverse_offsets_.empty();
+    }
+    size_t GetEdgeTarget(size_t edge_id) const{
+        return targets_[edge_id];
     }
-    const std::vector<std::vector<int>>& GetAllPrev()const{
-        return all_prev_;
+    // время ребра при текущих настройках (SetEdgeWeights)
+    double GetEdgeWeight(size_t edge_id) const{
+        return weights_[edge_id];
     }
-    const std::vector<GraphEdge>& GetEdges() const{
-        return edges_;
+    // время ребра при произвольных настройках, считается из расстояния
+    double GetEdgeWeight(size_t edge_id, const EdgeWeights& weights) const{
+        return weights.Weight(distances_[edge_id], edge_info_[edge_id].IsWait());
+    }
+    // длина поездки в метрах, 0 у ребра ожидания
+    double GetEdgeDistance(size_t edge_id) const{
+        return distances_[edge_id];
+    }
+    const EdgeWeights& GetEdgeWeights() const{
+        return edge_weights_;
+    }
+    // Пересчитывает времена ребер из расстояний за один проход по ребрам. Таблица
+    // маршрутов и индексы поверх графа посчитаны для старых настроек - их перестраивает владелец
+    void SetEdgeWeights(const EdgeWeights& weights){
+        edge_weights_ = weights;
+        weights_.resize(distances_.size());
+        for(size_t edge_id = 0; edge_id < distances_.size(); ++edge_id){
+            weights_[edge_id] = GetEdgeWeight(edge_id, edge_weights_);
+        }
+    }
+    EdgeInfo GetEdgeInfo(size_t edge_id) const{
+        return edge_info_[edge_id];
+    }
+    // Ребра вершины v лежат в [offsets_[v], offsets_[v + 1]), поэтому начало ребра ищем бинпоиском
+    size_t GetEdgeSource(size_t edge_id) const{
+        auto it = std::upper_bound(offsets_.begin(), offsets_.end(), static_cast<uint32_t>(edge_id));
+        return static_cast<size_t>(it - offsets_.begin()) - 1;
+    }
+    const std::string& GetStopName(size_t stop_idx) const{
+        return index_to_stop_[stop_idx];
+    }
+    const std::string& GetBusName(size_t bus_id) const{
+        return index_to_bus_[bus_id];
+    }
+    size_t GetBusCount() const{
+        return index_to_bus_.size();
+    }
+    size_t GetStopCount() const{
+        return index_to_stop_.size();
+    }
+    geo::Coordinates GetStopCoordinates(size_t stop_idx) const{
+        return stop_coordinates_[stop_idx];
+    }
+    size_t GetVertexCount() const{
+        return vertex_count_;
+    }
+    // Остановки, через которые ходит хотя бы один автобус, - индексы [0, GetServedStopCount()).
+    // У остальных нет вершин: маршрут есть только из остановки в нее же
+    size_t GetServedStopCount() const{
+        return vertex_count_ / 2;
+    }
+    bool HasVertices(size_t stop_idx) const{
+        return stop_idx < GetServedStopCount();
+    }
+    // Из ребер board->wait с общими концами оставлять только самое быстрое (первое из равных).
+    // Кратчайшие пути от этого не меняются, но альтернативы Йена теряют варианты,
+    // отличающиеся лишь автобусом на перегоне. Действует на следующий BuildEdges
+    void SetDropDominatedEdges(bool drop){
+        drop_dominated_edges_ = drop;
+    }
+    // Таблица Precomputed посчитана; без обслуживаемых остановок в ней нет строк, и это тоже полная таблица
+    bool HasAllRoutes() const{
+        return !route_table_.Empty() || GetServedStopCount() == 0;
     }
     size_t WaitVertex(const std::string& name) const{
         return stop_to_index_.at(name) * 2;
@@ -36,132 +175,744 @@ public:
     size_t BoardVertex(const std::string& name) const{
         return stop_to_index_.at(name) * 2 + 1;
     }
-    void BuildGraph(const transport::TransportCatalogue& tc){
+    // Нумерация остановок и автобусов без построения ребер.
+    // Индекс автобуса - его позиция при обходе tc.GetBuses(), индексы остановок - по order,
+    // но остановки без автобусов идут последними и вершин не получают (см. GetServedStopCount)
+    void BuildStopIndex(const transport::TransportCatalogue& tc, StopOrder order = StopOrder::Catalogue){
         const std::unordered_map<std::string, transport::Stop>* all_stops = tc.GetStops();
         const std::unordered_map<std::string, transport::Bus>* all_buses = tc.GetBuses();
-        double bus_wait_time = tc.GetWaitTime();;
-        double bus_velocity = tc.GetVelocity();
         size_t idx = 0;
+        stop_to_index_.clear();
+        index_to_stop_.clear();
+        stop_coordinates_.clear();
         stop_to_index_.reserve(all_stops->size());
         index_to_stop_.reserve(all_stops->size());
+        stop_coordinates_.reserve(all_stops->size());
         for(const auto& [name, stop] : *all_stops){
             stop_to_index_[name] = idx;
             index_to_stop_.push_back(name);
+            stop_coordinates_.push_back({ stop.coordinate.latitude, stop.coordinate.longitude });
             ++idx;
         }
+        index_to_bus_.clear();
+        index_to_bus_.reserve(all_buses->size());
+        for(const auto& [bus_name, bus] : *all_buses){
+            index_to_bus_.push_back(bus_name);
+        }
+        ReorderStops(tc, order);
+    }
+    // Граф хранится в CSR: исходящие ребра вершины v - это [offsets_[v], offsets_[v + 1]),
+    // номер ребра совпадает с его позицией в targets_/distances_/weights_/edge_info_.
+    // thread_count == 0 - по числу ядер
+    void BuildGraph(const transport::TransportCatalogue& tc, size_t thread_count = 0,
+        StopOrder order = StopOrder::Catalogue){
+        BuildStopIndex(tc, order);
+        BuildEdges(tc, thread_count);
+    }
+    // Ребра по каталогу при уже готовой нумерации остановок и автобусов.
+    // Расстояния перегонов каждого автобуса достаются из каталога один раз, затем
+    // по точным числам ребер каждая поездка (автобус, посадка, направление) получает
+    // свой диапазон номеров, и автобусы заполняют ребра параллельно. Порядок ребер
+    // тот же, что при последовательном добавлении, и не зависит от числа потоков.
+    void BuildEdges(const transport::TransportCatalogue& tc, size_t thread_count = 0){
+        const std::unordered_map<std::string, transport::Bus>* all_buses = tc.GetBuses();
+        const size_t n_stops = GetServedStopCount();
 
-        vertex_count_ = all_stops->size() * 2;
-        adjacency_.resize(vertex_count_);
-        edges_.clear();
+        std::unordered_map<std::string_view, uint32_t> bus_to_index;
+        bus_to_index.reserve(index_to_bus_.size());
+        for(size_t id = 0; id < index_to_bus_.size(); ++id){
+            bus_to_index[index_to_bus_[id]] = static_cast<uint32_t>(id);
+        }
 
-        for(const auto& [name, stop] : *all_stops){
-            size_t wait_vertex = WaitVertex(name);
-            size_t board_vertex = BoardVertex(name);
+        // автобусы в порядке обхода каталога, их остановки - подряд в общем массиве
+        struct BusSpan {
+            const transport::Bus* bus;
+            uint32_t bus_id;
+            size_t begin;// первая остановка в route_stops
+            size_t size;
+        };
+        std::vector<BusSpan> spans;
+        spans.reserve(all_buses->size());
+        size_t route_total = 0;
+        for(const auto& [bus_name, bus] : *all_buses){
+            spans.push_back(BusSpan{ &bus, bus_to_index.at(bus_name), route_total, bus.route.size() });
+            route_total += bus.route.size();
+        }
 
-            GraphEdge edge;
-            edge.from = wait_vertex;
-            edge.to = board_vertex;
-            edge.weight = bus_wait_time;
-            edge.is_wait = true;
-            edge.stop_name = name;
-            edge.span_count = 0;
+        // 1 проход, параллельно: индексы остановок и длины перегонов.
+        // forward[k] - от k-1 до k, backward[k] - от k+1 до k (по позициям в маршруте)
+        std::vector<uint32_t> route_stops(route_total);
+        std::vector<double> forward(route_total, 0.0);
+        std::vector<double> backward(route_total, 0.0);
+        ParallelForWorkStealing(spans.size(), thread_count, [&](size_t, size_t b){
+            const BusSpan& span = spans[b];
+            const auto& route = span.bus->route;
+            for(size_t k = 0; k < span.size; ++k){
+                route_stops[span.begin + k] = static_cast<uint32_t>(stop_to_index_.at(route[k]));
+                if(k > 0){
+                    forward[span.begin + k] = tc.GetRoadDistance(route[k - 1], route[k]);
+                }
+                if(!span.bus->is_ring && k + 1 < span.size){
+                    backward[span.begin + k] = tc.GetRoadDistance(route[k + 1], route[k]);
+                }
+            }
+        });
 
-            size_t edge_id = edges_.size();
-            edges_.push_back(std::move(edge));
-            adjacency_[wait_vertex].push_back(edge_id);
+        // 2 проход: число исходящих ребер каждой вершины
+        offsets_.assign(vertex_count_ + 1, 0);
+        for(size_t stop_idx = 0; stop_idx < n_stops; ++stop_idx){
+            ++offsets_[stop_idx * 2 + 1];
         }
+        for(const BusSpan& span : spans){
+            for(size_t i = 0; i < span.size; ++i){
+                uint32_t out_edges = static_cast<uint32_t>(span.size - 1 - i);
+                if(!span.bus->is_ring){
+                    out_edges += static_cast<uint32_t>(i);
+                }
+                offsets_[route_stops[span.begin + i] * 2 + 2] += out_edges;
+            }
+        }
+        for(size_t v = 0; v < vertex_count_; ++v){
+            offsets_[v + 1] += offsets_[v];
+        }
+        size_t edge_count = offsets_[vertex_count_];
+        targets_.resize(edge_count);
+        distances_.resize(edge_count);
+        edge_info_.resize(edge_count);
 
-        double speed_m_per_min = bus_velocity * (1000.0 / 60.0);
-
-        for(const auto& [bus_name, bus] : *all_buses){
-            const auto route = bus.route;
-            for(int i = 0; i < route.size(); ++i){
-                double accumulate_distance = 0.0;
-                for(int j = i + 1; j < route.size(); ++j){
-                    accumulate_distance += tc.GetRoadDistance(route[j - 1], route[j]);
-                    double travel_time = accumulate_distance / speed_m_per_min;
+        // 3 проход: первый номер ребра каждой поездки - в том порядке, в каком поездки
+        // шли бы при последовательном добавлении (вперед по посадкам, затем назад)
+        std::vector<uint32_t> cursor(offsets_.begin(), offsets_.end() - 1);
+        std::vector<uint32_t> forward_start(route_total);
+        std::vector<uint32_t> backward_start(route_total);
+        for(const BusSpan& span : spans){
+            for(size_t i = 0; i < span.size; ++i){
+                uint32_t& next = cursor[route_stops[span.begin + i] * 2 + 1];
+                forward_start[span.begin + i] = next;
+                next += static_cast<uint32_t>(span.size - 1 - i);
+            }
+            if(!span.bus->is_ring){
+                for(size_t i = span.size; i-- > 0;){
+                    uint32_t& next = cursor[route_stops[span.begin + i] * 2 + 1];
+                    backward_start[span.begin + i] = next;
+                    next += static_cast<uint32_t>(i);
+                }
+            }
+        }
 
-                    GraphEdge edge;
-                    edge.from = BoardVertex(route[i]);
-                    edge.to = WaitVertex(route[j]);
-                    edge.weight = travel_time;
-                    edge.is_wait = false;
-                    edge.bus_name = bus_name;
-                    edge.span_count = static_cast<int>(j - i);
+        for(size_t stop_idx = 0; stop_idx < n_stops; ++stop_idx){
+            uint32_t edge_id = offsets_[stop_idx * 2];
+            targets_[edge_id] = static_cast<uint32_t>(stop_idx * 2 + 1);
+            distances_[edge_id] = 0.0;
+            edge_info_[edge_id] = EdgeInfo{};
+        }
 
-                    size_t edge_id = edges_.size();
-                    edges_.push_back(edge);
-                    adjacency_[edge.from].push_back(edge_id);
+        // 4 проход, параллельно: каждый автобус пишет только в свои диапазоны
+        ParallelForWorkStealing(spans.size(), thread_count, [&](size_t, size_t b){
+            const BusSpan& span = spans[b];
+            const uint32_t* stops = route_stops.data() + span.begin;
+            for(size_t i = 0; i < span.size; ++i){
+                uint32_t edge_id = forward_start[span.begin + i];
+                double accumulate_distance = 0.0;
+                for(size_t j = i + 1; j < span.size; ++j, ++edge_id){
+                    accumulate_distance += forward[span.begin + j];
+                    targets_[edge_id] = stops[j] * 2;
+                    distances_[edge_id] = accumulate_distance;
+                    edge_info_[edge_id] = EdgeInfo{ span.bus_id, static_cast<uint32_t>(j - i) };
                 }
             }
             //обратное направление для некольцевого маршрута
-            if(!bus.is_ring){
-                for(size_t i = route.size(); i-- > 0;){
+            if(!span.bus->is_ring){
+                for(size_t i = span.size; i-- > 0;){
+                    uint32_t edge_id = backward_start[span.begin + i];
                     double accumulate_distance = 0.0;
-                    for(size_t j = i; j-- > 0;){
-                        accumulate_distance += tc.GetRoadDistance(route[j + 1], route[j]);
-                        double travel_time = accumulate_distance / speed_m_per_min;
-
-                        GraphEdge edge;
-                        edge.from = BoardVertex(route[i]);
-                        edge.to = WaitVertex(route[j]);
-                        edge.weight = travel_time;
-                        edge.is_wait = false;
-                        edge.bus_name = bus_name;
-                        edge.span_count = static_cast<int>(j - i);
-
-                        size_t edge_id = edges_.size();
-                        edges_.push_back(edge);
-                        adjacency_[edge.from].push_back(edge_id);
+                    for(size_t j = i; j-- > 0; ++edge_id){
+                        accumulate_distance += backward[span.begin + j];
+                        targets_[edge_id] = stops[j] * 2;
+                        distances_[edge_id] = accumulate_distance;
+                        edge_info_[edge_id] = EdgeInfo{ span.bus_id, static_cast<uint32_t>(i - j) };
                     }
                 }
             }
+        });
+        if(drop_dominated_edges_){
+            DropDominatedEdges();
         }
-        PrecomputeAllRoutes(tc);
+        SetEdgeWeights(EdgeWeights::FromSettings(tc.GetWaitTime(), tc.GetVelocity()));
     }
-private:
-    // Предвычисленные результаты
-    void PrecomputeAllRoutes(const transport::TransportCatalogue& tc){
+    // Остановки каталога те же, что в графе, и автобусы ходят только через остановки
+    // с вершинами: тогда ребра можно обновить через UpdateEdges
+    bool HasSameStops(const transport::TransportCatalogue& tc) const{
+        const std::unordered_map<std::string, transport::Stop>* all_stops = tc.GetStops();
+        if(all_stops->size() != index_to_stop_.size()){
+            return false;
+        }
+        for(const auto& [name, stop] : *all_stops){
+            if(!stop_to_index_.count(name)){
+                return false;
+            }
+        }
+        // остановка, через которую раньше не ходили автобусы, не имеет вершин
+        for(const auto& [bus_name, bus] : *tc.GetBuses()){
+            for(const std::string& stop_name : bus.route){
+                if(!HasVertices(stop_to_index_.at(stop_name))){
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    // Изменения ребер после UpdateEdges
+    struct EdgeDiff {
+        static constexpr uint32_t kRemoved = std::numeric_limits<uint32_t>::max();
+
+        std::vector<uint32_t> old_to_new;// старый номер ребра -> новый или kRemoved
+        std::vector<uint32_t> added;// новые ребра, которых раньше не было или был другой вес
+    };
+    // Пересобирает ребра по измененному каталогу (добавлены/удалены автобусы, изменены
+    // расстояния) при тех же остановках, см. HasSameStops. Номера оставшихся автобусов
+    // сохраняются, новые занимают номера удаленных, а когда их нет - номера в конце, так что
+    // список автобусов не растет от правок сверх наибольшего их числа. Имя удаленного
+    // остается без ребер до повторного занятия номера; полная перестройка нумерует заново.
+    // Ребро считается тем же, если совпали начало, конец, автобус, число пролетов и вес;
+    // изменение веса выглядит как удаление старого ребра и добавление нового.
+    // Настройки времени ребер (SetEdgeWeights) остаются прежними.
+    EdgeDiff UpdateEdges(const transport::TransportCatalogue& tc, size_t thread_count = 0){
+        {
+            // имена - ключи в index_to_bus_, поэтому список меняется только после поиска
+            std::unordered_map<std::string_view, uint32_t> bus_to_index;
+            bus_to_index.reserve(index_to_bus_.size());
+            for(size_t id = 0; id < index_to_bus_.size(); ++id){
+                bus_to_index.emplace(index_to_bus_[id], static_cast<uint32_t>(id));
+            }
+            std::vector<char> in_catalogue(index_to_bus_.size(), 0);
+            std::vector<std::string_view> added_buses;
+            for(const auto& [bus_name, bus] : *tc.GetBuses()){
+                auto it = bus_to_index.find(bus_name);
+                if(it == bus_to_index.end()){
+                    added_buses.push_back(bus_name);
+                }
+                else{
+                    in_catalogue[it->second] = 1;
+                }
+            }
+            // новые имена - в свободные номера по возрастанию, остаток - в конец
+            size_t free_id = 0;
+            for(std::string_view name : added_buses){
+                while(free_id < in_catalogue.size() && in_catalogue[free_id]){
+                    ++free_id;
+                }
+                if(free_id < in_catalogue.size()){
+                    in_catalogue[free_id] = 1;
+                    index_to_bus_[free_id] = std::string(name);
+                }
+                else{
+                    index_to_bus_.emplace_back(name);
+                }
+            }
+        }
+        std::vector<uint32_t> old_offsets = std::move(offsets_);
+        std::vector<uint32_t> old_targets = std::move(targets_);
+        std::vector<double> old_weights = std::move(weights_);
+        std::vector<EdgeInfo> old_info = std::move(edge_info_);
+        const EdgeWeights edge_weights = edge_weights_;
+        BuildEdges(tc, thread_count);
+        SetEdgeWeights(edge_weights);
+        reverse_offsets_.clear();
+        reverse_edge_ids_.clear();
+        reverse_sources_.clear();
+
+        EdgeDiff diff;
+        diff.old_to_new.assign(old_targets.size(), EdgeDiff::kRemoved);
+        std::vector<uint32_t> old_order;
+        std::vector<uint32_t> new_order;
+        for(size_t v = 0; v < vertex_count_; ++v){
+            // сравниваем ребра вершины, упорядоченные по (конец, автобус, пролеты, вес)
+            auto sorted = [](std::vector<uint32_t>& order, uint32_t begin, uint32_t end,
+                const std::vector<uint32_t>& targets, const std::vector<double>& weights, const std::vector<EdgeInfo>& info){
+                order.resize(end - begin);
+                for(uint32_t k = 0; k < end - begin; ++k){
+                    order[k] = begin + k;
+                }
+                std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs){
+                    return std::tie(targets[lhs], info[lhs].bus_id, info[lhs].span_count, weights[lhs])
+                        < std::tie(targets[rhs], info[rhs].bus_id, info[rhs].span_count, weights[rhs]);
+                });
+            };
+            sorted(old_order, old_offsets[v], old_offsets[v + 1], old_targets, old_weights, old_info);
+            sorted(new_order, offsets_[v], offsets_[v + 1], targets_, weights_, edge_info_);
+
+            size_t i = 0;
+            size_t j = 0;
+            while(i < old_order.size() || j < new_order.size()){
+                if(j == new_order.size()){
+                    ++i;
+                    continue;
+                }
+                if(i == old_order.size()){
+                    diff.added.push_back(new_order[j++]);
+                    continue;
+                }
+                uint32_t a = old_order[i];
+                uint32_t b = new_order[j];
+                auto old_key = std::tie(old_targets[a], old_info[a].bus_id, old_info[a].span_count, old_weights[a]);
+                auto new_key = std::tie(targets_[b], edge_info_[b].bus_id, edge_info_[b].span_count, weights_[b]);
+                if(old_key < new_key){
+                    ++i;
+                }
+                else if(new_key < old_key){
+                    diff.added.push_back(b);
+                    ++j;
+                }
+                else{
+                    diff.old_to_new[a] = b;
+                    ++i;
+                    ++j;
+                }
+            }
+        }
+        return diff;
+    }
+    // Обратный CSR для поиска от цели: входящие ребра каждой вершины
+    // в порядке возрастания номера ребра
+    void BuildReverseAdjacency(){
+        size_t edge_count = targets_.size();
+        reverse_offsets_.assign(vertex_count_ + 1, 0);
+        for(size_t edge_id = 0; edge_id < edge_count; ++edge_id){
+            ++reverse_offsets_[targets_[edge_id] + 1];
+        }
+        for(size_t v = 0; v < vertex_count_; ++v){
+            reverse_offsets_[v + 1] += reverse_offsets_[v];
+        }
+        reverse_edge_ids_.resize(edge_count);
+        reverse_sources_.resize(edge_count);
+        std::vector<uint32_t> cursor(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+        for(size_t v = 0; v < vertex_count_; ++v){
+            for(uint32_t edge_id = offsets_[v]; edge_id < offsets_[v + 1]; ++edge_id){
+                uint32_t pos = cursor[targets_[edge_id]]++;
+                reverse_edge_ids_[pos] = edge_id;
+                reverse_sources_[pos] = static_cast<uint32_t>(v);
+            }
+        }
+    }
+    // Дейкстра из wait-вершины остановки stop_idx в готовые массивы размера vertex_count_.
+    // Queue - одна из очередей priority_queues.h, переиспользуется между вызовами
+    template <typename Queue>
+    void ComputeShortestPaths(size_t stop_idx, double* dist, int* prev_e, Queue& queue) const{
         const double INF = std::numeric_limits<double>::infinity();
-        size_t n_stops = tc.GetStops()->size();
-        all_dist_.assign(n_stops, std::vector<double>(vertex_count_, INF));
-        all_prev_.assign(n_stops, std::vector<int>(vertex_count_, -1));
-
-        using PQItem = std::pair<double, size_t>;
-
-        for (size_t si = 0; si < n_stops; ++si) {
-            size_t start = si * 2; 
-            auto& dist = all_dist_[si];
-            auto& prev_e = all_prev_[si];
-            dist[start] = 0.0;
-
-            std::priority_queue<PQItem, std::vector<PQItem>, std::greater<PQItem>> pq;
-            pq.push({ 0.0, start });
-
-            while (!pq.empty()) {
-                auto [d, v] = pq.top();
-                pq.pop();
-                if (d > dist[v]) continue;
-                for (size_t edge_id : adjacency_[v]) {
-                    const GraphEdge& e = edges_[edge_id];
-                    double nd = dist[v] + e.weight;
-                    if (nd < dist[e.to]) {
-                        dist[e.to] = nd;
-                        prev_e[e.to] = static_cast<int>(edge_id);
-                        pq.push({ nd, e.to });
+        std::fill(dist, dist + vertex_count_, INF);
+        std::fill(prev_e, prev_e + vertex_count_, -1);
+        queue.Reset(vertex_count_);
+
+        size_t start = stop_idx * 2;
+        dist[start] = 0.0;
+        queue.Push(0.0, start);
+
+        while (!queue.Empty()) {
+            auto [d, v] = queue.Pop();
+            if (d > dist[v]) continue;
+            for (uint32_t edge_id = offsets_[v]; edge_id < offsets_[v + 1]; ++edge_id) {
+                size_t to = targets_[edge_id];
+                double nd = dist[v] + weights_[edge_id];
+                if (nd < dist[to]) {
+                    dist[to] = nd;
+                    prev_e[to] = static_cast<int>(edge_id);
+                    queue.Push(nd, to);
+                }
+            }
+        }
+    }
+    // Остановки, до которых из stop_idx можно доехать не дольше max_time, и время до них.
+    // Вершины дальше бюджета в очередь не попадают, так что поиск не выходит за изохрону
+    std::vector<std::pair<size_t, double>> FindReachableStops(size_t stop_idx, double max_time) const{
+        std::vector<std::pair<size_t, double>> reachable;
+        if(max_time < 0.0){
+            return reachable;
+        }
+        // массивы пространства не чистятся, так что малая изохрона не платит за весь граф
+        SearchWorkspace::Lease search = SearchWorkspace::Borrow(vertex_count_);
+        LazyBinaryHeap& queue = search->Queue();
+        size_t start = stop_idx * 2;
+        search->Set(start, 0.0, SearchWorkspace::kNoEdge);
+        queue.Push(0.0, start);
+        while(!queue.Empty()){
+            auto [d, v] = queue.Pop();
+            if(d > search->Dist(v)) continue;
+            if(v % 2 == 0){
+                reachable.emplace_back(v / 2, d);
+            }
+            for(uint32_t edge_id = offsets_[v]; edge_id < offsets_[v + 1]; ++edge_id){
+                size_t to = targets_[edge_id];
+                double nd = d + weights_[edge_id];
+                if(nd <= max_time && nd < search->Dist(to)){
+                    search->Set(to, nd, edge_id);
+                    queue.Push(nd, to);
+                }
+            }
+        }
+        return reachable;
+    }
+    ShortestPathTree BuildShortestPathTree(size_t stop_idx, QueueKind queue_kind = QueueKind::BinaryHeap) const{
+        ShortestPathTree tree;
+        tree.dist.resize(vertex_count_);
+        tree.prev_edge.resize(vertex_count_);
+        // массивы дерева уходят в кэш, а очередь потока переиспользуется между запросами
+        VisitQueue(queue_kind, [&](auto queue) {
+            using Queue = decltype(queue);
+            ComputeShortestPaths(stop_idx, tree.dist.data(), tree.prev_edge.data(), SearchWorkspace::ThreadQueue<Queue>());
+        });
+        return tree;
+    }
+    // Путь между остановками при других настройках, без таблицы и кэша: время ребра
+    // выводится из расстояния при релаксации, поиск идет в пространстве потока и
+    // останавливается, как только извлечена wait-вершина цели. Ребра - в прямом порядке
+    bool FindPath(size_t from_stop, size_t to_stop, const EdgeWeights& weights, std::vector<size_t>& path_edges) const{
+        path_edges.clear();
+        SearchWorkspace::Lease search = SearchWorkspace::Borrow(vertex_count_);
+        LazyBinaryHeap& queue = search->Queue();
+        const size_t start = from_stop * 2;
+        const size_t target = to_stop * 2;
+        search->Set(start, 0.0, SearchWorkspace::kNoEdge);
+        queue.Push(0.0, start);
+        bool reached = false;
+        while(!queue.Empty()){
+            auto [d, v] = queue.Pop();
+            if(d > search->Dist(v)) continue;
+            if(v == target){
+                reached = true;
+                break;
+            }
+            for(uint32_t edge_id = offsets_[v]; edge_id < offsets_[v + 1]; ++edge_id){
+                size_t to = targets_[edge_id];
+                double nd = d + GetEdgeWeight(edge_id, weights);
+                if(nd < search->Dist(to)){
+                    search->Set(to, nd, edge_id);
+                    queue.Push(nd, to);
+                }
+            }
+        }
+        if(!reached){
+            return false;
+        }
+        for(size_t cur = target; search->PrevEdge(cur) != SearchWorkspace::kNoEdge; cur = GetEdgeSource(search->PrevEdge(cur))){
+            path_edges.push_back(search->PrevEdge(cur));
+        }
+        std::reverse(path_edges.begin(), path_edges.end());
+        return true;
+    }
+    // Предвычисленные результаты для всех пар остановок в одной таблице RouteTable.
+    // Источники раздаются потокам с воровством работы, у каждого потока свои буферы;
+    // результат не зависит от числа потоков. thread_count == 0 - по числу ядер.
+    void PrecomputeAllRoutes(size_t thread_count = 0, QueueKind queue_kind = QueueKind::BinaryHeap,
+        bool huge_pages = false){
+        size_t n_stops = GetServedStopCount();
+        route_table_.Reset(n_stops, vertex_count_, huge_pages);
+
+        struct Scratch {
+            std::vector<double> dist;
+            std::vector<int> prev_e;
+        };
+        size_t workers = ResolveThreadCount(thread_count, n_stops);
+        std::vector<Scratch> scratch(workers, Scratch{ std::vector<double>(vertex_count_), std::vector<int>(vertex_count_) });
+        VisitQueue(queue_kind, [&](auto queue) {
+            std::vector<decltype(queue)> queues(workers);
+            ParallelForWorkStealing(n_stops, workers, [&](size_t worker, size_t si) {
+                Scratch& buffers = scratch[worker];
+                ComputeShortestPaths(si, buffers.dist.data(), buffers.prev_e.data(), queues[worker]);
+                // строку пишет только этот поток, так что страницы таблицы достаются его узлу памяти
+                RouteCell* row = route_table_.Row(si);
+                for (size_t v = 0; v < vertex_count_; ++v) {
+                    row[v].dist = static_cast<float>(buffers.dist[v]);
+                    row[v].prev_edge = static_cast<uint32_t>(buffers.prev_e[v]);
+                }
+            });
+        });
+    }
+    // Приводит таблицу маршрутов в соответствие ребрам после UpdateEdges.
+    // Строка пересчитывается заново, только если ее дерево идет по удаленному ребру или
+    // какое-то новое ребро может сократить (или сравнять) ее время; в остальных строках
+    // лишь перенумеровываются ребра. Возвращает число пересчитанных строк.
+    size_t UpdateAllRoutes(const EdgeDiff& diff, size_t thread_count = 0, QueueKind queue_kind = QueueKind::BinaryHeap){
+        route_table_.Detach();
+        size_t n_stops = GetServedStopCount();
+
+        struct NewEdge {
+            uint32_t from;
+            uint32_t to;
+            double weight;
+        };
+        std::vector<NewEdge> added;
+        added.reserve(diff.added.size());
+        for(uint32_t edge_id : diff.added){
+            added.push_back({ static_cast<uint32_t>(GetEdgeSource(edge_id)), targets_[edge_id], weights_[edge_id] });
+        }
+
+        struct Scratch {
+            std::vector<double> dist;
+            std::vector<int> prev_e;
+        };
+        size_t workers = ResolveThreadCount(thread_count, n_stops);
+        std::vector<Scratch> scratch(workers);
+        std::vector<char> recomputed(n_stops, 0);
+        VisitQueue(queue_kind, [&](auto queue) {
+            std::vector<decltype(queue)> queues(workers);
+            ParallelForWorkStealing(n_stops, workers, [&](size_t worker, size_t si) {
+                RouteCell* row = route_table_.Row(si);
+                bool affected = false;
+                // ребро вне старого графа бывает только в испорченной таблице из файла - строку пересчитываем
+                for(size_t v = 0; v < vertex_count_ && !affected; ++v){
+                    affected = row[v].prev_edge != RouteCell::kNoEdge
+                        && (row[v].prev_edge >= diff.old_to_new.size()
+                            || diff.old_to_new[row[v].prev_edge] == EdgeDiff::kRemoved);
+                }
+                // в таблице float, поэтому сравниваем с запасом: лишний пересчет не страшен
+                for(size_t k = 0; k < added.size() && !affected; ++k){
+                    double from_dist = row[added[k].from].dist;
+                    affected = from_dist != std::numeric_limits<double>::infinity()
+                        && from_dist + added[k].weight <= static_cast<double>(row[added[k].to].dist) * (1.0 + 1e-6);
+                }
+                if(!affected){
+                    for(size_t v = 0; v < vertex_count_; ++v){
+                        if(row[v].prev_edge != RouteCell::kNoEdge){
+                            row[v].prev_edge = diff.old_to_new[row[v].prev_edge];
+                        }
                     }
+                    return;
+                }
+                Scratch& buffers = scratch[worker];
+                buffers.dist.resize(vertex_count_);
+                buffers.prev_e.resize(vertex_count_);
+                ComputeShortestPaths(si, buffers.dist.data(), buffers.prev_e.data(), queues[worker]);
+                for(size_t v = 0; v < vertex_count_; ++v){
+                    row[v].dist = static_cast<float>(buffers.dist[v]);
+                    row[v].prev_edge = static_cast<uint32_t>(buffers.prev_e[v]);
                 }
+                recomputed[si] = 1;
+            });
+        });
+        return static_cast<size_t>(std::count(recomputed.begin(), recomputed.end(), 1));
+    }
+    // Сохраняет граф и таблицу маршрутов, если она посчитана. Обратный CSR не сохраняется -
+    // его дешевле построить заново. Таблица выравнивается по странице, чтобы
+    // Deserialize мог читать ее прямо из отображенного файла.
+    void Serialize(binary_io::Writer& writer) const{
+        writer.WriteStrings(index_to_stop_);
+        writer.WriteVector(stop_coordinates_);
+        writer.WriteStrings(index_to_bus_);
+        writer.WriteVector(offsets_);
+        writer.WriteVector(targets_);
+        writer.WriteVector(distances_);
+        writer.Write(edge_weights_.wait_time);
+        writer.Write(edge_weights_.speed_m_per_min);
+        writer.WriteVector(edge_info_);
+        writer.Write<uint64_t>(vertex_count_);
+        writer.Write<uint64_t>(route_table_.GetRowCount());
+        if (!route_table_.Empty()) {
+            writer.Align(kTablePageSize);
+            writer.WriteBytes(route_table_.Row(0),
+                route_table_.GetRowCount() * route_table_.GetColumnCount() * sizeof(RouteCell));
+        }
+    }
+    // Читает то, что записал Serialize. Массивы графа копируются, таблица маршрутов
+    // остается в file и подгружается страницами по мере обращения
+    void Deserialize(binary_io::Reader& reader, std::shared_ptr<const MappedFile> file){
+        index_to_stop_ = reader.ReadStrings();
+        stop_coordinates_ = reader.ReadVector<geo::Coordinates>();
+        index_to_bus_ = reader.ReadStrings();
+        offsets_ = reader.ReadVector<uint32_t>();
+        targets_ = reader.ReadVector<uint32_t>();
+        distances_ = reader.ReadVector<double>();
+        EdgeWeights edge_weights;
+        edge_weights.wait_time = reader.Read<double>();
+        edge_weights.speed_m_per_min = reader.Read<double>();
+        edge_info_ = reader.ReadVector<EdgeInfo>();
+        vertex_count_ = static_cast<size_t>(reader.Read<uint64_t>());
+        size_t rows = static_cast<size_t>(reader.Read<uint64_t>());
+
+        if (stop_coordinates_.size() != index_to_stop_.size() || vertex_count_ % 2 != 0
+            || vertex_count_ > index_to_stop_.size() * 2
+            || offsets_.size() != vertex_count_ + 1 || offsets_.back() != targets_.size()
+            || distances_.size() != targets_.size() || edge_info_.size() != targets_.size()
+            || !(edge_weights.speed_m_per_min > 0.0) || !(edge_weights.wait_time >= 0.0)
+            || (rows != 0 && rows != GetServedStopCount())) {
+            throw binary_io::FormatError("Inconsistent graph in binary file");
+        }
+        // GetEdgeSource ищет двоичным поиском, так что смещения должны идти по неубыванию
+        if (offsets_.front() != 0 || !std::is_sorted(offsets_.begin(), offsets_.end())) {
+            throw binary_io::FormatError("Inconsistent graph in binary file");
+        }
+        for (size_t edge_id = 0; edge_id < targets_.size(); ++edge_id) {
+            const EdgeInfo& info = edge_info_[edge_id];
+            if (targets_[edge_id] >= vertex_count_ || !(distances_[edge_id] >= 0.0)
+                || (!info.IsWait() && info.bus_id >= index_to_bus_.size())) {
+                throw binary_io::FormatError("Inconsistent graph in binary file");
+            }
+        }
+
+        SetEdgeWeights(edge_weights);
+        stop_to_index_.clear();
+        for (size_t i = 0; i < index_to_stop_.size(); ++i) {
+            stop_to_index_[index_to_stop_[i]] = i;
+        }
+        reverse_offsets_.clear();
+        reverse_edge_ids_.clear();
+        reverse_sources_.clear();
+
+        if (rows != 0) {
+            reader.Align(kTablePageSize);
+            const RouteCell* cells = reader.View<RouteCell>(rows * vertex_count_);
+            route_table_.Attach(cells, rows, vertex_count_, std::move(file));
+        }
+        else {
+            route_table_.Reset(0, 0, false);
+        }
+    }
+private:
+    // Перенумеровывает остановки из порядка каталога в порядок order, остановки без
+    // автобусов - в конец с сохранением порядка; вершины получают только первые
+    void ReorderStops(const transport::TransportCatalogue& tc, StopOrder order){
+        const size_t n_stops = index_to_stop_.size();
+        std::vector<char> served(n_stops, 0);
+        for(const auto& [bus_name, bus] : *tc.GetBuses()){
+            for(const std::string& stop_name : bus.route){
+                served[stop_to_index_.at(stop_name)] = 1;
+            }
+        }
+        std::vector<uint32_t> new_to_old;
+        if(order == StopOrder::Hilbert){
+            new_to_old = OrderStopsByHilbert(stop_coordinates_);
+        }
+        else if(order == StopOrder::Bfs){
+            std::vector<std::vector<uint32_t>> neighbours(n_stops);
+            for(const auto& [bus_name, bus] : *tc.GetBuses()){
+                for(size_t i = 1; i < bus.route.size(); ++i){
+                    uint32_t from = static_cast<uint32_t>(stop_to_index_.at(bus.route[i - 1]));
+                    uint32_t to = static_cast<uint32_t>(stop_to_index_.at(bus.route[i]));
+                    if(from != to){
+                        neighbours[from].push_back(to);
+                        neighbours[to].push_back(from);
+                    }
+                }
+            }
+            for(auto& list : neighbours){
+                std::sort(list.begin(), list.end());
+                list.erase(std::unique(list.begin(), list.end()), list.end());
             }
+            new_to_old = OrderStopsByBfs(neighbours);
+        }
+        else{
+            new_to_old.resize(n_stops);
+            for(size_t idx = 0; idx < n_stops; ++idx){
+                new_to_old[idx] = static_cast<uint32_t>(idx);
+            }
+        }
+        auto first_unserved = std::stable_partition(new_to_old.begin(), new_to_old.end(), [&](uint32_t old_idx){
+            return served[old_idx] != 0;
+        });
+        vertex_count_ = static_cast<size_t>(first_unserved - new_to_old.begin()) * 2;
+
+        bool identity = true;
+        for(size_t new_idx = 0; new_idx < n_stops && identity; ++new_idx){
+            identity = new_to_old[new_idx] == new_idx;
+        }
+        if(identity){
+            return;
+        }
+        std::vector<std::string> names(n_stops);
+        std::vector<geo::Coordinates> coordinates(n_stops);
+        for(size_t new_idx = 0; new_idx < n_stops; ++new_idx){
+            names[new_idx] = std::move(index_to_stop_[new_to_old[new_idx]]);
+            coordinates[new_idx] = stop_coordinates_[new_to_old[new_idx]];
+        }
+        index_to_stop_ = std::move(names);
+        stop_coordinates_ = std::move(coordinates);
+        for(size_t new_idx = 0; new_idx < n_stops; ++new_idx){
+            stop_to_index_[index_to_stop_[new_idx]] = new_idx;
         }
-        
     }
+    // Оставляет у каждой board-вершины по одному ребру на конечную wait-вершину: самое
+    // короткое (значит, и самое быстрое при любой скорости), из равных - первое, то есть
+    // то, которое выбрала бы Дейкстра. Номера ребер сжимаются с сохранением порядка.
+    // Вызывается до SetEdgeWeights, времена ребер еще не посчитаны
+    void DropDominatedEdges(){
+        std::vector<uint32_t> best(vertex_count_, 0);// best[target] - ребро-победитель текущей вершины
+        std::vector<uint32_t> seen(vertex_count_, 0);// seen[target] == v + 1 - у вершины v уже есть ребро в target
+        std::vector<char> keep(targets_.size(), 1);
+        for(size_t v = 1; v < vertex_count_; v += 2){
+            const uint32_t stamp = static_cast<uint32_t>(v + 1);
+            for(uint32_t edge_id = offsets_[v]; edge_id < offsets_[v + 1]; ++edge_id){
+                uint32_t to = targets_[edge_id];
+                if(seen[to] != stamp){
+                    seen[to] = stamp;
+                    best[to] = edge_id;
+                }
+                else if(distances_[edge_id] < distances_[best[to]]){
+                    keep[best[to]] = 0;
+                    best[to] = edge_id;
+                }
+                else{
+                    keep[edge_id] = 0;
+                }
+            }
+        }
+        uint32_t write = 0;
+        uint32_t read_begin = 0;
+        for(size_t v = 0; v < vertex_count_; ++v){
+            uint32_t read_end = offsets_[v + 1];
+            offsets_[v] = write;
+            for(uint32_t edge_id = read_begin; edge_id < read_end; ++edge_id){
+                if(keep[edge_id]){
+                    targets_[write] = targets_[edge_id];
+                    distances_[write] = distances_[edge_id];
+                    edge_info_[write] = edge_info_[edge_id];
+                    ++write;
+                }
+            }
+            read_begin = read_end;
+        }
+        offsets_[vertex_count_] = write;
+        targets_.resize(write);
+        distances_.resize(write);
+        edge_info_.resize(write);
+        targets_.shrink_to_fit();
+        distances_.shrink_to_fit();
+        edge_info_.shrink_to_fit();
+    }
+
+    static constexpr size_t kTablePageSize = 4096;
+
+    // вызывает fn с пустой очередью нужного типа
+    template <typename Fn>
+    static void VisitQueue(QueueKind queue_kind, Fn&& fn) {
+        switch (queue_kind) {
+        case QueueKind::BinaryHeap:
+            fn(LazyBinaryHeap{});
+            break;
+        case QueueKind::QuaternaryHeap:
+            fn(QuaternaryHeap{});
+            break;
+        case QueueKind::RadixHeap:
+            fn(RadixHeap{});
+            break;
+        }
+    }
+
     std::unordered_map<std::string, size_t> stop_to_index_;//имя остановки -> базовый индекс
     std::vector<std::string> index_to_stop_;// базовый индекс -> имя остановки
-    std::vector<std::vector<size_t>> adjacency_;
-    std::vector<GraphEdge> edges_;
-    size_t vertex_count_ = 0;
-    // all_dist_[stop_idx][vertex] = мин время из wait-вершины stop_idx
-    std::vector<std::vector<double>> all_dist_;
-    // all_prev_[stop_idx][vertex] = индекс ребра, по которому пришли
-    std::vector<std::vector<int>> all_prev_;
+    std::vector<geo::Coordinates> stop_coordinates_;// базовый индекс -> координаты остановки
+    std::vector<std::string> index_to_bus_;// индекс автобуса -> номер автобуса
+    std::vector<uint32_t> offsets_;// offsets_[v] - первое исходящее ребро вершины v
+    std::vector<uint32_t> targets_;// targets_[edge] - вершина, куда ведет ребро
+    std::vector<double> distances_;// distances_[edge] - длина поездки в метрах, 0 у ожидания
+    std::vector<double> weights_;// weights_[edge] - время в минутах при edge_weights_
+    EdgeWeights edge_weights_;
+    std::vector<EdgeInfo> edge_info_;// edge_info_[edge] - автобус и число пролетов
+    // обратный CSR, заполняется BuildReverseAdjacency
+    std::vector<uint32_t> reverse_offsets_;
+    std::vector<uint32_t> reverse_edge_ids_;// номер прямого ребра
+    std::vector<uint32_t> reverse_sources_;// откуда ведет ребро
+    size_t vertex_count_ = 0;// 2 * число остановок с автобусами
+    bool drop_dominated_edges_ = false;
+    // route_table_.Row(stop_idx)[vertex] = мин время из wait-вершины stop_idx и ребро, по которому пришли
+    RouteTable route_table_;
 };
\ No newline at end of file
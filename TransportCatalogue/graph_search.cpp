@@ -0,0 +1,270 @@
+#include "graph_search.h"
+#include "geo.h"
+#include "search_workspace.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+
+namespace {
+    using PQItem = std::pair<double, size_t>;
+    constexpr size_t kNoEdge = std::numeric_limits<size_t>::max();
+
+    // acos в geo::ComputeDistance дает NaN для совпадающих точек
+    double GeoDistance(geo::Coordinates from, geo::Coordinates to) {
+        double distance = geo::ComputeDistance(from, to);
+        return std::isfinite(distance) ? distance : 0.0;
+    }
+
+    // Сторона поиска поверх SearchWorkspace: массивы размером в граф не чистятся между запросами
+    struct SearchSide {
+        SearchWorkspace::Lease workspace;
+
+        SearchSide(size_t vertex_count, size_t start, double start_key = 0.0)
+            : workspace(SearchWorkspace::Borrow(vertex_count)) {
+            workspace->Set(start, 0.0, SearchWorkspace::kNoEdge);
+            workspace->Queue().Push(start_key, start);
+        }
+        double Dist(size_t v) const {
+            return workspace->Dist(v);
+        }
+        // прямой поиск: ребро, по которому пришли; обратный: по которому уходим к цели
+        size_t Edge(size_t v) const {
+            uint32_t edge_id = workspace->PrevEdge(v);
+            return edge_id == SearchWorkspace::kNoEdge ? kNoEdge : edge_id;
+        }
+        bool Empty() const {
+            return workspace->Queue().Empty();
+        }
+        // убирает из вершины кучи устаревшие элементы
+        bool Normalize() {
+            LazyBinaryHeap& queue = workspace->Queue();
+            while (!queue.Empty() && queue.Top().first > Dist(queue.Top().second)) {
+                queue.Pop();
+            }
+            return !queue.Empty();
+        }
+        double Top() const {
+            return workspace->Queue().Top().first;
+        }
+        PQItem Pop() {
+            return workspace->Queue().Pop();
+        }
+        bool Relax(size_t v, double nd, size_t edge_id) {
+            return Relax(v, nd, edge_id, nd);
+        }
+        // key - приоритет в куче, для A* это nd + эвристика
+        bool Relax(size_t v, double nd, size_t edge_id, double key) {
+            if (nd < Dist(v)) {
+                workspace->Set(v, nd, static_cast<uint32_t>(edge_id));
+                workspace->Queue().Push(key, v);
+                return true;
+            }
+            return false;
+        }
+    };
+}
+
+double FindPathBidirectional(const Graph& graph, size_t source, size_t target, std::vector<size_t>& path_edges) {
+    const double INF = std::numeric_limits<double>::infinity();
+    path_edges.clear();
+    if (source == target) {
+        return 0.0;
+    }
+
+    const size_t n = graph.GetVertexCount();
+    SearchSide forward(n, source);
+    SearchSide backward(n, target);
+    double best = INF;
+    size_t meet = n;
+
+    while (forward.Normalize() && backward.Normalize()) {
+        if (forward.Top() + backward.Top() >= best) {
+            break;
+        }
+        if (forward.Top() <= backward.Top()) {
+            size_t v = forward.Pop().second;
+            for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+                size_t to = graph.GetEdgeTarget(edge_id);
+                double nd = forward.Dist(v) + graph.GetEdgeWeight(edge_id);
+                forward.Relax(to, nd, edge_id);
+                if (nd + backward.Dist(to) < best) {
+                    best = nd + backward.Dist(to);
+                    meet = to;
+                }
+            }
+        }
+        else {
+            size_t v = backward.Pop().second;
+            for (size_t pos = graph.ReverseEdgesBegin(v); pos < graph.ReverseEdgesEnd(v); ++pos) {
+                size_t edge_id = graph.GetReverseEdgeId(pos);
+                size_t from = graph.GetReverseEdgeSource(pos);
+                double nd = backward.Dist(v) + graph.GetEdgeWeight(edge_id);
+                backward.Relax(from, nd, edge_id);
+                if (nd + forward.Dist(from) < best) {
+                    best = nd + forward.Dist(from);
+                    meet = from;
+                }
+            }
+        }
+    }
+
+    if (meet == n) {
+        return INF;
+    }
+    for (size_t v = meet; forward.Edge(v) != kNoEdge; v = graph.GetEdgeSource(forward.Edge(v))) {
+        path_edges.push_back(forward.Edge(v));
+    }
+    std::reverse(path_edges.begin(), path_edges.end());
+    for (size_t v = meet; backward.Edge(v) != kNoEdge; v = graph.GetEdgeTarget(backward.Edge(v))) {
+        path_edges.push_back(backward.Edge(v));
+    }
+    return best;
+}
+
+double ComputeGeoLowerBound(const Graph& graph) {
+    const double INF = std::numeric_limits<double>::infinity();
+    double minutes_per_meter = INF;
+    for (size_t v = 1; v < graph.GetVertexCount(); v += 2) {// board-вершины
+        for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+            EdgeInfo info = graph.GetEdgeInfo(edge_id);
+            if (info.IsWait() || info.span_count != 1) continue;
+            double geo = GeoDistance(graph.GetStopCoordinates(v / 2),
+                graph.GetStopCoordinates(graph.GetEdgeTarget(edge_id) / 2));
+            if (geo <= 0.0) continue;
+            minutes_per_meter = std::min(minutes_per_meter, graph.GetEdgeWeight(edge_id) / geo);
+        }
+    }
+    if (!std::isfinite(minutes_per_meter) || minutes_per_meter <= 0.0) {
+        return 0.0;
+    }
+    // запас на погрешность сферической формулы
+    return minutes_per_meter * (1.0 - 1e-9);
+}
+
+double FindPathAStar(const Graph& graph, size_t source, size_t target, double minutes_per_meter,
+    std::vector<size_t>& path_edges) {
+    const double INF = std::numeric_limits<double>::infinity();
+    path_edges.clear();
+
+    const size_t n = graph.GetVertexCount();
+    const geo::Coordinates goal = graph.GetStopCoordinates(target / 2);
+    // эвристика считается один раз на остановку; отметки эпох вместо заполнения NaN
+    SearchWorkspace::Lease stop_bound = SearchWorkspace::Borrow(graph.GetStopCount());
+    auto heuristic = [&](size_t v) {
+        size_t stop = v / 2;
+        if (!stop_bound->Reached(stop)) {
+            stop_bound->Set(stop, minutes_per_meter > 0.0
+                ? GeoDistance(graph.GetStopCoordinates(stop), goal) * minutes_per_meter
+                : 0.0, SearchWorkspace::kNoEdge);
+        }
+        return stop_bound->Dist(stop);
+    };
+
+    SearchSide search(n, source, heuristic(source));
+    while (!search.Empty()) {
+        auto [key, v] = search.Pop();
+        if (key > search.Dist(v) + heuristic(v)) continue;
+        if (v == target) break;
+        for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+            size_t to = graph.GetEdgeTarget(edge_id);
+            double nd = search.Dist(v) + graph.GetEdgeWeight(edge_id);
+            if (nd < search.Dist(to)) {
+                search.Relax(to, nd, edge_id, nd + heuristic(to));
+            }
+        }
+    }
+
+    if (search.Dist(target) == INF) {
+        return INF;
+    }
+    for (size_t v = target; search.Edge(v) != kNoEdge; v = graph.GetEdgeSource(search.Edge(v))) {
+        path_edges.push_back(search.Edge(v));
+    }
+    std::reverse(path_edges.begin(), path_edges.end());
+    return search.Dist(target);
+}
+
+std::vector<std::vector<size_t>> FindParetoPaths(const Graph& graph, size_t source_stop, size_t target_stop,
+    size_t max_rides) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const size_t stop_count = graph.GetStopCount();
+
+    // arrival[r * stop_count + s] - время в wait-вершине s не более чем за r поездок,
+    // ride_edge - ребро поездки, которым пришли в s именно в раунде r
+    std::vector<double> arrival(stop_count, INF);
+    std::vector<size_t> ride_edge(stop_count, kNoEdge);
+    std::vector<double> best(stop_count, INF);
+    arrival[source_stop] = 0.0;
+    best[source_stop] = 0.0;
+
+    std::vector<size_t> marked_stops{ source_stop };
+    std::vector<size_t> next_marked;
+    std::vector<char> is_marked(stop_count, 0);
+    std::vector<size_t> front_rounds;
+    size_t rounds = 0;
+
+    while (!marked_stops.empty() && rounds < max_rides) {
+        ++rounds;
+        const size_t prev = (rounds - 1) * stop_count;
+        const size_t cur = rounds * stop_count;
+        arrival.resize(cur + stop_count);
+        std::copy(arrival.begin() + prev, arrival.begin() + cur, arrival.begin() + cur);
+        ride_edge.resize(cur + stop_count, kNoEdge);
+
+        for (size_t stop : marked_stops) {
+            is_marked[stop] = 0;
+        }
+        // посадка только по времени прошлого раунда, поэтому в раунде ровно одна новая поездка
+        for (size_t stop : marked_stops) {
+            const size_t wait = stop * 2;
+            for (size_t wait_edge = graph.EdgesBegin(wait); wait_edge < graph.EdgesEnd(wait); ++wait_edge) {
+                const size_t board = graph.GetEdgeTarget(wait_edge);
+                const double board_time = arrival[prev + stop] + graph.GetEdgeWeight(wait_edge);
+                for (size_t edge_id = graph.EdgesBegin(board); edge_id < graph.EdgesEnd(board); ++edge_id) {
+                    const size_t to = graph.GetEdgeTarget(edge_id) / 2;
+                    const double time = board_time + graph.GetEdgeWeight(edge_id);
+                    if (time < best[to] && time < best[target_stop]) {
+                        best[to] = time;
+                        arrival[cur + to] = time;
+                        ride_edge[cur + to] = edge_id;
+                        if (!is_marked[to]) {
+                            is_marked[to] = 1;
+                            next_marked.push_back(to);
+                        }
+                    }
+                }
+            }
+        }
+        if (ride_edge[cur + target_stop] != kNoEdge) {
+            front_rounds.push_back(rounds);
+        }
+        marked_stops.swap(next_marked);
+        next_marked.clear();
+    }
+
+    std::vector<std::vector<size_t>> paths;
+    for (size_t round : front_rounds) {
+        std::vector<size_t> path_edges;
+        size_t stop = target_stop;
+        for (size_t r = round; r > 0; --r) {
+            const size_t edge_id = ride_edge[r * stop_count + stop];
+            if (edge_id == kNoEdge) {
+                continue;// в этом раунде s не улучшилась, время пришло из прошлого
+            }
+            const size_t board = graph.GetEdgeSource(edge_id);
+            stop = board / 2;
+            path_edges.push_back(edge_id);
+            for (size_t wait_edge = graph.EdgesBegin(stop * 2); wait_edge < graph.EdgesEnd(stop * 2); ++wait_edge) {
+                if (graph.GetEdgeTarget(wait_edge) == board) {
+                    path_edges.push_back(wait_edge);
+                    break;
+                }
+            }
+        }
+        std::reverse(path_edges.begin(), path_edges.end());
+        paths.push_back(std::move(path_edges));
+    }
+    return paths;
+}
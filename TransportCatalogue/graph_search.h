@@ -0,0 +1,30 @@
+#pragma once
+#include "graph.h"
+#include <cstddef>
+#include <vector>
+
+// Поиски между парой вершин Graph для режимов без предвычисленных таблиц.
+// Возвращают время пути (бесконечность, если пути нет) и ребра пути в прямом порядке.
+
+// Двунаправленная Дейкстра: прямой поиск от source и обратный от target по
+// обратному CSR (Graph::BuildReverseAdjacency), остановка, когда сумма вершин
+// обеих очередей не меньше лучшего найденного пути через точку встречи.
+double FindPathBidirectional(const Graph& graph, size_t source, size_t target, std::vector<size_t>& path_edges);
+
+// Нижняя оценка для A*: минут на метр расстояния по прямой. Берется минимум
+// weight / geo по ребрам ровно в один пролет; по неравенству треугольника оценка
+// годится и для длинных ребер, даже если дорога короче расстояния по прямой.
+// 0, если допустимой оценки нет (нулевые дороги, нет ребер) - тогда A* это Дейкстра.
+double ComputeGeoLowerBound(const Graph& graph);
+
+// A* от source к target с эвристикой geo(v, target) * minutes_per_meter
+double FindPathAStar(const Graph& graph, size_t source, size_t target, double minutes_per_meter,
+    std::vector<size_t>& path_edges);
+
+// Парето-фронт по (время, число поездок) от остановки source_stop до target_stop.
+// Поиск идет раундами: раунд k - лучшие времена не более чем за k поездок, метки
+// хранятся плоскими массивами [раунд][остановка]. Каждый следующий путь фронта
+// содержит больше поездок и строго быстрее предыдущего; больше max_rides поездок
+// поиск не делает. Пути - ребра в прямом порядке до wait-вершины target_stop
+std::vector<std::vector<size_t>> FindParetoPaths(const Graph& graph, size_t source_stop, size_t target_stop,
+    size_t max_rides);
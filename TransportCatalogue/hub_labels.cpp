@@ -0,0 +1,194 @@
+#include "hub_labels.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <utility>
+
+namespace {
+    using PQItem = std::pair<double, uint32_t>;
+}
+
+void HubLabels::Build(const Graph& graph) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const uint32_t n = static_cast<uint32_t>(graph.GetVertexCount());
+
+    // сначала вершины, через которые проходит больше путей: грубо - с большей степенью
+    order_.resize(n);
+    std::vector<uint64_t> importance(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        order_[v] = v;
+        uint64_t out_degree = graph.EdgesEnd(v) - graph.EdgesBegin(v);
+        uint64_t in_degree = graph.ReverseEdgesEnd(v) - graph.ReverseEdgesBegin(v);
+        importance[v] = (out_degree + 1) * (in_degree + 1);
+    }
+    std::stable_sort(order_.begin(), order_.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return importance[lhs] > importance[rhs];
+    });
+
+    std::vector<std::vector<Entry>> out_labels(n);
+    std::vector<std::vector<Entry>> in_labels(n);
+    std::vector<double> dist(n, INF);
+    std::vector<uint32_t> via(n, kNoEdge);
+    std::vector<uint32_t> touched;
+    std::vector<PQItem> heap;
+    // расстояния от/до текущего хаба по его уже готовой метке, индекс - ранг
+    std::vector<double> hub_dist(n, INF);
+
+    auto pruned_search = [&](uint32_t rank, bool forward) {
+        const uint32_t hub = order_[rank];
+        // forward: ищем пути hub -> v, проверяем out(hub) + in(v), пишем в in(v)
+        auto& own_labels = forward ? out_labels : in_labels;
+        auto& target_labels = forward ? in_labels : out_labels;
+        for (const Entry& e : own_labels[hub]) hub_dist[e.hub] = e.dist;
+
+        dist[hub] = 0.0;
+        touched.push_back(hub);
+        heap.push_back({ 0.0, hub });
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<PQItem>{});
+            auto [d, v] = heap.back();
+            heap.pop_back();
+            if (d > dist[v]) continue;
+
+            bool covered = false;
+            for (const Entry& e : target_labels[v]) {
+                if (hub_dist[e.hub] + e.dist <= d) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (covered) continue;
+            target_labels[v].push_back(Entry{ rank, via[v], d });
+
+            if (forward) {
+                for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+                    uint32_t to = static_cast<uint32_t>(graph.GetEdgeTarget(edge_id));
+                    double nd = d + graph.GetEdgeWeight(edge_id);
+                    if (nd < dist[to]) {
+                        if (dist[to] == INF) touched.push_back(to);
+                        dist[to] = nd;
+                        via[to] = static_cast<uint32_t>(edge_id);
+                        heap.push_back({ nd, to });
+                        std::push_heap(heap.begin(), heap.end(), std::greater<PQItem>{});
+                    }
+                }
+            }
+            else {
+                for (size_t pos = graph.ReverseEdgesBegin(v); pos < graph.ReverseEdgesEnd(v); ++pos) {
+                    uint32_t from = static_cast<uint32_t>(graph.GetReverseEdgeSource(pos));
+                    size_t edge_id = graph.GetReverseEdgeId(pos);
+                    double nd = d + graph.GetEdgeWeight(edge_id);
+                    if (nd < dist[from]) {
+                        if (dist[from] == INF) touched.push_back(from);
+                        dist[from] = nd;
+                        via[from] = static_cast<uint32_t>(edge_id);
+                        heap.push_back({ nd, from });
+                        std::push_heap(heap.begin(), heap.end(), std::greater<PQItem>{});
+                    }
+                }
+            }
+        }
+
+        for (uint32_t v : touched) {
+            dist[v] = INF;
+            via[v] = kNoEdge;
+        }
+        touched.clear();
+        for (const Entry& e : own_labels[hub]) hub_dist[e.hub] = INF;
+    };
+
+    // хабы добавляются по возрастанию ранга, поэтому метки сразу отсортированы
+    for (uint32_t rank = 0; rank < n; ++rank) {
+        pruned_search(rank, true);
+        pruned_search(rank, false);
+    }
+
+    auto flatten = [n](std::vector<std::vector<Entry>>& labels, std::vector<uint32_t>& offsets, std::vector<Entry>& entries) {
+        offsets.assign(n + 1, 0);
+        entries.clear();
+        for (uint32_t v = 0; v < n; ++v) {
+            entries.insert(entries.end(), labels[v].begin(), labels[v].end());
+            offsets[v + 1] = static_cast<uint32_t>(entries.size());
+            std::vector<Entry>().swap(labels[v]);
+        }
+    };
+    flatten(out_labels, out_offsets_, out_entries_);
+    flatten(in_labels, in_offsets_, in_entries_);
+}
+
+double HubLabels::Merge(size_t source, size_t target, size_t& out_pos, size_t& in_pos) const {
+    double best = std::numeric_limits<double>::infinity();
+    size_t i = out_offsets_[source];
+    size_t j = in_offsets_[target];
+    const size_t i_end = out_offsets_[source + 1];
+    const size_t j_end = in_offsets_[target + 1];
+    while (i < i_end && j < j_end) {
+        if (out_entries_[i].hub < in_entries_[j].hub) {
+            ++i;
+        }
+        else if (out_entries_[i].hub > in_entries_[j].hub) {
+            ++j;
+        }
+        else {
+            double d = out_entries_[i].dist + in_entries_[j].dist;
+            if (d < best) {
+                best = d;
+                out_pos = i;
+                in_pos = j;
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return best;
+}
+
+double HubLabels::FindTravelTime(size_t source, size_t target) const {
+    if (source == target) {
+        return 0.0;
+    }
+    size_t out_pos = 0;
+    size_t in_pos = 0;
+    return Merge(source, target, out_pos, in_pos);
+}
+
+const HubLabels::Entry* HubLabels::FindEntry(const std::vector<uint32_t>& offsets, const std::vector<Entry>& entries,
+    size_t v, uint32_t hub) const {
+    auto begin = entries.begin() + offsets[v];
+    auto end = entries.begin() + offsets[v + 1];
+    auto it = std::lower_bound(begin, end, hub, [](const Entry& e, uint32_t h) {
+        return e.hub < h;
+    });
+    return it != end && it->hub == hub ? &*it : nullptr;
+}
+
+double HubLabels::FindPath(const Graph& graph, size_t source, size_t target, std::vector<size_t>& path_edges) const {
+    path_edges.clear();
+    if (source == target) {
+        return 0.0;
+    }
+    size_t out_pos = 0;
+    size_t in_pos = 0;
+    double best = Merge(source, target, out_pos, in_pos);
+    if (best == std::numeric_limits<double>::infinity()) {
+        return best;
+    }
+
+    // source -> hub: вершины на пути к хабу не были отсечены, у каждой есть запись о нем
+    const uint32_t hub = out_entries_[out_pos].hub;
+    const size_t hub_vertex = order_[hub];
+    for (size_t v = source; v != hub_vertex;) {
+        const Entry* e = FindEntry(out_offsets_, out_entries_, v, hub);
+        path_edges.push_back(e->edge);
+        v = graph.GetEdgeTarget(e->edge);
+    }
+    // hub -> target собираем с конца
+    size_t middle = path_edges.size();
+    for (size_t v = target; v != hub_vertex;) {
+        const Entry* e = FindEntry(in_offsets_, in_entries_, v, hub);
+        path_edges.push_back(e->edge);
+        v = graph.GetEdgeSource(e->edge);
+    }
+    std::reverse(path_edges.begin() + middle, path_edges.end());
+    return best;
+}
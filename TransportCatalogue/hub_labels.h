@@ -0,0 +1,45 @@
+#pragma once
+#include "graph.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Двухшаговая разметка (pruned landmark labeling) над Graph.
+// У каждой вершины две метки, отсортированные по рангу хаба: out - расстояния
+// от вершины до хабов, in - от хабов до вершины. Время пути s -> t - минимум
+// out(s)[h] + in(t)[h] по общим хабам, то есть слияние двух отсортированных списков.
+// Каждая запись хранит еще первое/последнее ребро пути до хаба, по ним путь
+// разворачивается в ребра Graph без поиска.
+class HubLabels {
+public:
+    // Нужен обратный CSR (Graph::BuildReverseAdjacency)
+    void Build(const Graph& graph);
+
+    // Время пути или бесконечность, если пути нет
+    double FindTravelTime(size_t source, size_t target) const;
+    // То же плюс ребра Graph пути в прямом порядке
+    double FindPath(const Graph& graph, size_t source, size_t target, std::vector<size_t>& path_edges) const;
+
+    size_t GetLabelEntryCount() const {
+        return out_entries_.size() + in_entries_.size();
+    }
+private:
+    static constexpr uint32_t kNoEdge = UINT32_MAX;
+
+    struct Entry {
+        uint32_t hub;// ранг хаба
+        uint32_t edge;// out: первое ребро пути к хабу, in: последнее ребро пути от хаба
+        double dist;
+    };
+
+    // лучший общий хаб; возвращает расстояние и позиции записей в метках
+    double Merge(size_t source, size_t target, size_t& out_pos, size_t& in_pos) const;
+    const Entry* FindEntry(const std::vector<uint32_t>& offsets, const std::vector<Entry>& entries,
+        size_t v, uint32_t hub) const;
+
+    std::vector<uint32_t> order_;// ранг -> вершина
+    std::vector<uint32_t> out_offsets_;
+    std::vector<Entry> out_entries_;
+    std::vector<uint32_t> in_offsets_;
+    std::vector<Entry> in_entries_;
+};
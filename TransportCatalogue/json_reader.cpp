@@ -3,6 +3,10 @@
 #include "json_builder.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 
 static const json::Node* FindValue(const json::Dict& dict, const std::string_view key) {
@@ -14,6 +18,62 @@ static const json::Node* FindValue(const json::Dict& dict, const std::string_vie
     return nullptr;
 }
 
+// "bus_wait_time" и "bus_velocity" поверх weights; отсутствующие остаются прежними.
+// Отрицательное ожидание или неположительная скорость сломали бы Дейкстру, такие значения пропускаются
+static EdgeWeights ApplyEdgeWeights(const json::Dict& map, EdgeWeights weights) {
+    if (const json::Node* wait_time = FindValue(map, "bus_wait_time"); wait_time && wait_time->AsDouble() >= 0.0) {
+        weights.wait_time = wait_time->AsDouble();
+    }
+    if (const json::Node* velocity = FindValue(map, "bus_velocity"); velocity && velocity->AsDouble() > 0.0) {
+        weights.speed_m_per_min = EdgeWeights::SpeedFromVelocity(velocity->AsDouble());
+    }
+    return weights;
+}
+
+// Расписание автобуса: явный список "departures" или интервал "headway" между
+// "first_departure" и "last_departure" включительно (по умолчанию - сутки), минуты.
+// Моменты - в пределах суток, интервал не меньше минуты: иначе один автобус дал бы
+// миллиарды рейсов. Неверное расписание - std::invalid_argument с номером автобуса
+static std::vector<double> ReadDepartures(const json::Dict& bus) {
+    using namespace std::literals;
+    constexpr double kDayMinutes = 24.0 * 60.0;
+    constexpr double kMinHeadway = 1.0;
+    auto check = [&bus](bool valid, std::string_view what) {
+        if (!valid) {
+            throw std::invalid_argument("Bus "s + FindValue(bus, "name")->AsString() + ": "s + std::string(what));
+        }
+    };
+    auto in_day = [](double time) {
+        return time >= 0.0 && time <= kDayMinutes;// NaN сюда не проходит
+    };
+
+    std::vector<double> departures;
+    if (const json::Node* list = FindValue(bus, "departures")) {
+        for (const auto& time : list->AsArray()) {
+            check(in_day(time.AsDouble()), "departures must be within a day (0-1440 minutes)"sv);
+            departures.push_back(time.AsDouble());
+        }
+        return departures;
+    }
+    const json::Node* headway = FindValue(bus, "headway");
+    if (!headway) {
+        return departures;
+    }
+    const json::Node* first = FindValue(bus, "first_departure");
+    const json::Node* last = FindValue(bus, "last_departure");
+    const double step = headway->AsDouble();
+    const double first_time = first ? first->AsDouble() : 0.0;
+    const double last_time = last ? last->AsDouble() : kDayMinutes;
+    check(step >= kMinHeadway && std::isfinite(step), "headway must be at least 1 minute"sv);
+    check(in_day(first_time) && in_day(last_time), "first_departure and last_departure must be within a day"sv);
+    check(first_time <= last_time, "first_departure must not be later than last_departure"sv);
+    // умножение, а не накопление, чтобы не копить ошибку округления за сутки
+    for (size_t i = 0; first_time + i * step <= last_time; ++i) {
+        departures.push_back(first_time + i * step);
+    }
+    return departures;
+}
+
 void JsonReader::AddStops(const json::Array& requests, transport::TransportCatalogue& tc) {
     for (const auto& req : requests) {
         const auto& map = req.AsMap();
@@ -58,6 +118,7 @@ void JsonReader::AddBuses(const json::Array& requests, transport::TransportCatal
                 stops,
                 FindValue(map, "is_roundtrip")->AsBool()
             );
+            tc.SetBusDepartures(FindValue(map, "name")->AsString(), ReadDepartures(map));
         }
     }
 }
@@ -128,6 +189,45 @@ void JsonReader::ReadAndExecuteBaseRequests(transport::TransportCatalogue& tc, c
     AddRoutingSettings(tc, root);
 }
 
+bool JsonReader::HasUpdateRequests(const json::Node& root) const {
+    const json::Node* updates = FindValue(root.AsMap(), "update_requests");
+    return updates && !updates->AsArray().empty();
+}
+
+void JsonReader::ApplyUpdateRequests(transport::TransportCatalogue& tc, const json::Node& root, TransportRouter& router) {
+    const json::Node* updates = FindValue(root.AsMap(), "update_requests");
+    if (!updates || updates->AsArray().empty()) return;
+
+    for (const auto& req : updates->AsArray()) {
+        const auto& map = req.AsMap();
+        const std::string& type = FindValue(map, "type")->AsString();
+        if (type == "Bus") {
+            const std::string& name = FindValue(map, "name")->AsString();
+            std::vector<std::string> stops;
+            for (const auto& s : FindValue(map, "stops")->AsArray()) {
+                stops.push_back(s.AsString());
+            }
+            // расписание проверяется до правки каталога
+            std::vector<double> departures = ReadDepartures(map);
+            tc.RemoveBus(name);
+            tc.AddBus(name, stops, FindValue(map, "is_roundtrip")->AsBool());
+            tc.SetBusDepartures(name, std::move(departures));
+        }
+        else if (type == "RemoveBus") {
+            tc.RemoveBus(FindValue(map, "name")->AsString());
+        }
+        else if (type == "Distance") {
+            tc.SetRoadDistance(FindValue(map, "from")->AsString(), FindValue(map, "to")->AsString(),
+                FindValue(map, "distance")->AsInt());
+        }
+    }
+    router.Update(tc);
+    // карта рисуется по каталогу, поэтому перерисовываем ее
+    if (FindValue(root.AsMap(), "render_settings")) {
+        AddMap(root.AsMap(), tc);
+    }
+}
+
 const std::ostringstream& JsonReader::GetMap() {
     return map_out_;
 }
@@ -166,20 +266,125 @@ void JsonReader::AddBusBuilder(json::Builder& builder, const transport::Transpor
     }
 }
 
+void JsonReader::AddStopBuilder(json::Builder& builder, const transport::CatalogueSnapshot& snapshot, const json::Dict& this_map, const int id) {
+    using namespace std::literals;
+    const std::string& name = FindValue(this_map, "name")->AsString();
+    std::optional<uint32_t> stop = snapshot.FindStop(name);
+    builder.Key("request_id"s).Value(json::Node(id));
+    if (!stop) {
+        builder.Key("error_message"s).Value(json::Node("not found"s));
+    }
+    else {
+        json::Array buses_node;
+        for (uint32_t bus : snapshot.GetStopBuses(*stop)) {
+            buses_node.push_back(json::Node(std::string(snapshot.GetBusName(bus))));
+        }
+        builder.Key("buses"s).Value(json::Node(std::move(buses_node)));
+    }
+}
+
+void JsonReader::AddBusBuilder(json::Builder& builder, const transport::CatalogueSnapshot& snapshot, const json::Dict& this_map, const int id) {
+    using namespace std::literals;
+    const std::string& name = FindValue(this_map, "name")->AsString();
+    std::optional<uint32_t> bus = snapshot.FindBus(name);
+    builder.Key("request_id"s).Value(json::Node(id));
+    if (!bus) {
+        builder.Key("error_message"s).Value(json::Node("not found"s));
+    }
+    else {
+        auto stat = snapshot.GetBusStats(*bus);
+        builder.Key("curvature"s).Value(json::Node(stat.curvature));
+        builder.Key("route_length"s).Value(json::Node(static_cast<double>(stat.route_length)));
+        builder.Key("stop_count"s).Value(json::Node(static_cast<int>(stat.stops_on_route)));
+        builder.Key("unique_stop_count"s).Value(json::Node(static_cast<int>(stat.unique_stops)));
+    }
+}
+
+std::string JsonReader::GetMapSvg(const transport::TransportCatalogue&) {
+    return GetMap().str();
+}
+
+std::string JsonReader::GetMapSvg(const transport::CatalogueSnapshot& snapshot) {
+    return std::string(snapshot.GetMap());
+}
+
 void JsonReader::AddRouteBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router) {
     using namespace std::literals;
     const std::string& from = FindValue(this_map, "from")->AsString();
     const std::string& to = FindValue(this_map, "to")->AsString();
+    const json::Node* alternatives = FindValue(this_map, "alternatives");
+    const json::Node* max_transfers = FindValue(this_map, "max_transfers");
+    const json::Node* pareto = FindValue(this_map, "pareto");
+    const json::Node* departure_time = FindValue(this_map, "departure_time");
 
     builder.Key("request_id"s).Value(json::Node(id));
 
-    RouteResult route = router.FindRoute(from, to);
+    if (departure_time) {
+        RouteResult route = router.FindRouteAt(from, to, departure_time->AsDouble());
+        if (!route.found) {
+            builder.Key("error_message"s).Value(json::Node("not found"s));
+            return;
+        }
+        AddRouteItems(builder, route);
+        return;
+    }
+
+    if (max_transfers || (pareto && pareto->AsBool())) {
+        // самый быстрый маршрут в пределах пересадок сверху, фронт целиком - в routes по запросу
+        size_t limit = TransportRouter::kAnyTransfers;
+        if (max_transfers && max_transfers->AsInt() >= 0) {
+            limit = static_cast<size_t>(max_transfers->AsInt());
+        }
+        std::vector<RouteResult> routes = router.FindParetoRoutes(from, to, limit);
+        if (routes.empty()) {
+            builder.Key("error_message"s).Value(json::Node("not found"s));
+            return;
+        }
+        AddRouteItems(builder, routes.back());
+        if (pareto && pareto->AsBool()) {
+            builder.Key("routes"s).StartArray();
+            for (const auto& route : routes) {
+                builder.StartDict();
+                AddRouteItems(builder, route);
+                builder.EndDict();
+            }
+            builder.EndArray();
+        }
+        return;
+    }
+
+    if (!alternatives) {
+        // свои bus_wait_time/bus_velocity у запроса - сценарий "что если" без перестройки графа;
+        // альтернативы, Парето и расписание считаются при настройках сессии
+        const EdgeWeights weights = ApplyEdgeWeights(this_map, router.GetEdgeWeights());
+        // буфер живет между запросами, его items не выделяются заново
+        if (!router.FindRoute(from, to, weights, route_buffer_)) {
+            builder.Key("error_message"s).Value(json::Node("not found"s));
+            return;
+        }
+        AddRouteItems(builder, route_buffer_);
+        return;
+    }
 
-    if (!route.found) {
+    // лучший маршрут остается на верхнем уровне, как в ответе без alternatives
+    int k = alternatives->AsInt();
+    std::vector<RouteResult> routes = router.FindRoutes(from, to, k > 0 ? static_cast<size_t>(k) : 1);
+    if (routes.empty()) {
         builder.Key("error_message"s).Value(json::Node("not found"s));
         return;
     }
+    AddRouteItems(builder, routes.front());
+    builder.Key("routes"s).StartArray();
+    for (const auto& route : routes) {
+        builder.StartDict();
+        AddRouteItems(builder, route);
+        builder.EndDict();
+    }
+    builder.EndArray();
+}
 
+void JsonReader::AddRouteItems(json::Builder& builder, const RouteResult& route) {
+    using namespace std::literals;
     builder.Key("total_time"s).Value(json::Node(route.total_time));
     builder.Key("items"s).StartArray();
 
@@ -187,12 +392,12 @@ void JsonReader::AddRouteBuilder(json::Builder& builder, const json::Dict& this_
         builder.StartDict();
         if (item.is_wait) {
             builder.Key("type"s).Value(json::Node("Wait"s));
-            builder.Key("stop_name"s).Value(json::Node(item.stop_name));
+            builder.Key("stop_name"s).Value(json::Node(std::string(item.stop_name)));
             builder.Key("time"s).Value(json::Node(item.time));
         }
         else {
             builder.Key("type"s).Value(json::Node("Bus"s));
-            builder.Key("bus"s).Value(json::Node(item.bus_name));
+            builder.Key("bus"s).Value(json::Node(std::string(item.bus_name)));
             builder.Key("span_count"s).Value(json::Node(item.span_count));
             builder.Key("time"s).Value(json::Node(item.time));
         }
@@ -202,7 +407,99 @@ void JsonReader::AddRouteBuilder(json::Builder& builder, const json::Dict& this_
     builder.EndArray();
 }
 
+void JsonReader::AddRouteCacheStatsBuilder(json::Builder& builder, const int id, const TransportRouter& router) {
+    using namespace std::literals;
+    builder.Key("request_id"s).Value(json::Node(id));
+
+    std::optional<RouteResultCache::Stats> stats = router.GetResultCacheStats();
+    if (!stats) {
+        builder.Key("error_message"s).Value(json::Node("not found"s));
+        return;
+    }
+    // json::Node хранит целые как int, double печатается с 6 значащими цифрами,
+    // поэтому счетчик больше INT_MAX выводится как INT_MAX
+    auto counter = [](uint64_t value) {
+        return json::Node(static_cast<int>(std::min<uint64_t>(value, std::numeric_limits<int>::max())));
+    };
+    builder.Key("hits"s).Value(counter(stats->hits));
+    builder.Key("misses"s).Value(counter(stats->misses));
+    builder.Key("evictions"s).Value(counter(stats->evictions));
+    builder.Key("size"s).Value(counter(stats->size));
+    builder.Key("capacity"s).Value(counter(stats->capacity));
+}
+
+void JsonReader::AddTravelTimeBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router) {
+    using namespace std::literals;
+    const std::string& from = FindValue(this_map, "from")->AsString();
+    const std::string& to = FindValue(this_map, "to")->AsString();
+
+    builder.Key("request_id"s).Value(json::Node(id));
+
+    std::optional<double> time = router.FindTravelTime(from, to);
+    if (!time) {
+        builder.Key("error_message"s).Value(json::Node("not found"s));
+        return;
+    }
+    builder.Key("total_time"s).Value(json::Node(*time));
+}
+
+void JsonReader::AddReachableBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router) {
+    using namespace std::literals;
+    const std::string& from = FindValue(this_map, "from")->AsString();
+    const double max_time = FindValue(this_map, "max_time")->AsDouble();
+
+    builder.Key("request_id"s).Value(json::Node(id));
+
+    auto reachable = router.FindReachableStops(from, max_time);
+    if (!reachable) {
+        builder.Key("error_message"s).Value(json::Node("not found"s));
+        return;
+    }
+    builder.Key("stops"s).StartArray();
+    for (const auto& stop : *reachable) {
+        builder.StartDict();
+        builder.Key("stop_name"s).Value(json::Node(stop.stop_name));
+        builder.Key("time"s).Value(json::Node(stop.time));
+        builder.EndDict();
+    }
+    builder.EndArray();
+}
+
+void JsonReader::AddRouteMatrixBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router) {
+    using namespace std::literals;
+    auto read_names = [](const json::Node* node) {
+        std::vector<std::string> names;
+        for (const auto& name : node->AsArray()) {
+            names.push_back(name.AsString());
+        }
+        return names;
+    };
+    std::vector<std::string> from = read_names(FindValue(this_map, "from"));
+    std::vector<std::string> to = read_names(FindValue(this_map, "to"));
+
+    builder.Key("request_id"s).Value(json::Node(id));
+    // недостижимые пары и неизвестные остановки - null
+    builder.Key("total_times"s).StartArray();
+    for (const auto& row : router.FindTravelTimeMatrix(from, to)) {
+        builder.StartArray();
+        for (const auto& time : row) {
+            builder.Value(time ? json::Node(*time) : json::Node(nullptr));
+        }
+        builder.EndArray();
+    }
+    builder.EndArray();
+}
+
 json::Node JsonReader::ExecuteStatRequests(const transport::TransportCatalogue& tc, const json::Node& root, const TransportRouter& router) {
+    return ExecuteStatRequestsImpl(tc, root, router);
+}
+
+json::Node JsonReader::ExecuteStatRequests(const transport::CatalogueSnapshot& snapshot, const json::Node& root, const TransportRouter& router) {
+    return ExecuteStatRequestsImpl(snapshot, root, router);
+}
+
+template <typename Catalogue>
+json::Node JsonReader::ExecuteStatRequestsImpl(const Catalogue& catalogue, const json::Node& root, const TransportRouter& router) {
     using namespace std::literals;
     json::Builder builder;
     builder.StartArray();
@@ -218,19 +515,30 @@ json::Node JsonReader::ExecuteStatRequests(const transport::TransportCatalogue&
         builder.StartDict();
 
         if (type == "Bus") {
-            AddBusBuilder(builder, tc, this_map, id);
+            AddBusBuilder(builder, catalogue, this_map, id);
         }
         else if (type == "Stop") {
-            AddStopBuilder(builder, tc, this_map, id);
+            AddStopBuilder(builder, catalogue, this_map, id);
         }
         else if (type == "Map") {
-            const std::ostringstream& picture = GetMap();
-            builder.Key("map"s).Value(picture.str());
+            builder.Key("map"s).Value(GetMapSvg(catalogue));
             builder.Key("request_id"s).Value(json::Node(id));
         }
         else if (type == "Route") {
             AddRouteBuilder(builder,  this_map, id, router);
         }
+        else if (type == "Reachable") {
+            AddReachableBuilder(builder, this_map, id, router);
+        }
+        else if (type == "RouteMatrix") {
+            AddRouteMatrixBuilder(builder, this_map, id, router);
+        }
+        else if (type == "TravelTime") {
+            AddTravelTimeBuilder(builder, this_map, id, router);
+        }
+        else if (type == "RouteCacheStats") {
+            AddRouteCacheStatsBuilder(builder, id, router);
+        }
 
         builder.EndDict();
     }
@@ -247,3 +555,87 @@ void JsonReader::AddRoutingSettings(transport::TransportCatalogue& tc, const jso
     double bus_velocity = FindValue(routing->AsMap(), "bus_velocity")->AsDouble();
     tc.AddRoutingSettings(bus_wait_time, bus_velocity);
 }
+
+RouterSettings JsonReader::ReadRouterSettings(const json::Node& root) const {
+    RouterSettings settings;
+    const json::Node* routing = FindValue(root.AsMap(), "routing_settings");
+    if (!routing) return settings;
+
+    const auto& routing_map = routing->AsMap();
+    if (const json::Node* mode = FindValue(routing_map, "routing_mode")) {
+        const std::string& mode_name = mode->AsString();
+        if (mode_name == "on_demand") {
+            settings.mode = RoutingMode::OnDemand;
+        }
+        else if (mode_name == "bidirectional") {
+            settings.mode = RoutingMode::Bidirectional;
+        }
+        else if (mode_name == "astar") {
+            settings.mode = RoutingMode::AStar;
+        }
+        else if (mode_name == "contraction") {
+            settings.mode = RoutingMode::Contraction;
+        }
+        else if (mode_name == "hub_labels") {
+            settings.mode = RoutingMode::HubLabels;
+        }
+        else if (mode_name == "route_patterns") {
+            settings.mode = RoutingMode::RoutePatterns;
+        }
+        else {
+            settings.mode = RoutingMode::Precomputed;
+        }
+    }
+    if (const json::Node* cache_mb = FindValue(routing_map, "route_cache_mb")) {
+        settings.tree_cache_bytes = static_cast<size_t>(cache_mb->AsDouble() * 1024 * 1024);
+    }
+    if (const json::Node* threads = FindValue(routing_map, "routing_threads")) {
+        settings.threads = static_cast<size_t>(threads->AsInt());
+    }
+    if (const json::Node* queue = FindValue(routing_map, "routing_queue")) {
+        const std::string& queue_name = queue->AsString();
+        if (queue_name == "quaternary_heap") {
+            settings.queue = QueueKind::QuaternaryHeap;
+        }
+        else if (queue_name == "radix_heap") {
+            settings.queue = QueueKind::RadixHeap;
+        }
+        else {
+            settings.queue = QueueKind::BinaryHeap;
+        }
+    }
+    if (const json::Node* huge_pages = FindValue(routing_map, "route_table_huge_pages")) {
+        settings.huge_pages = huge_pages->AsBool();
+    }
+    if (const json::Node* cache_size = FindValue(routing_map, "route_result_cache_size")) {
+        settings.result_cache_entries = static_cast<size_t>(std::max(cache_size->AsInt(), 0));
+    }
+    if (const json::Node* minimize = FindValue(routing_map, "minimize_graph")) {
+        settings.minimize_graph = minimize->AsBool();
+    }
+    if (const json::Node* stop_order = FindValue(routing_map, "stop_order")) {
+        const std::string& order_name = stop_order->AsString();
+        if (order_name == "hilbert") {
+            settings.stop_order = StopOrder::Hilbert;
+        }
+        else if (order_name == "bfs") {
+            settings.stop_order = StopOrder::Bfs;
+        }
+        else {
+            settings.stop_order = StopOrder::Catalogue;
+        }
+    }
+    return settings;
+}
+
+EdgeWeights JsonReader::ReadEdgeWeights(const json::Node& root, const EdgeWeights& defaults) const {
+    const json::Node* routing = FindValue(root.AsMap(), "routing_settings");
+    return routing ? ApplyEdgeWeights(routing->AsMap(), defaults) : defaults;
+}
+
+std::string JsonReader::ReadSerializationFile(const json::Node& root, std::string_view key) const {
+    const json::Node* serialization = FindValue(root.AsMap(), "serialization_settings");
+    if (!serialization) return {};
+    const json::Node* file = FindValue(serialization->AsMap(), key);
+    return file ? file->AsString() : std::string{};
+}
@@ -1,9 +1,12 @@
 #pragma once
+#include "catalogue_snapshot.h"
 #include "json.h"
 #include "json_builder.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 #include <sstream>
+#include <string>
+#include <string_view>
 
 class JsonReader {
 public:
@@ -12,16 +15,41 @@ public:
 
     json::Node ExecuteStatRequests(const transport::TransportCatalogue& tc,
         const json::Node& root, const TransportRouter& router);
+    // То же, но Bus/Stop/Map отвечает снимок каталога
+    json::Node ExecuteStatRequests(const transport::CatalogueSnapshot& snapshot,
+        const json::Node& root, const TransportRouter& router);
+
+    // update_requests: изменения каталога после построения роутера
+    // (Bus - добавить или заменить автобус, RemoveBus, Distance), затем router.Update
+    void ApplyUpdateRequests(transport::TransportCatalogue& tc, const json::Node& root, TransportRouter& router);
+    bool HasUpdateRequests(const json::Node& root) const;
 
     void AddRoutingSettings(transport::TransportCatalogue& tc,
         const json::Node& root);
+    RouterSettings ReadRouterSettings(const json::Node& root) const;
+    // bus_wait_time и bus_velocity из routing_settings поверх defaults (см. TransportRouter::SetEdgeWeights)
+    EdgeWeights ReadEdgeWeights(const json::Node& root, const EdgeWeights& defaults) const;
+    // serialization_settings[key] или пустая строка
+    std::string ReadSerializationFile(const json::Node& root, std::string_view key = "file") const;
 private:
     void AddStops(const json::Array& requests, transport::TransportCatalogue& tc);
     void AddRoutes(const json::Array& requests, transport::TransportCatalogue& tc);
     void AddBuses(const json::Array& requests, transport::TransportCatalogue& tc);
     void AddMap(const json::Dict& root_map, transport::TransportCatalogue& tc);
+    template <typename Catalogue>
+    json::Node ExecuteStatRequestsImpl(const Catalogue& catalogue, const json::Node& root, const TransportRouter& router);
     void AddStopBuilder(json::Builder& builder, const transport::TransportCatalogue& tc, const json::Dict& this_map, const int id);
+    void AddStopBuilder(json::Builder& builder, const transport::CatalogueSnapshot& snapshot, const json::Dict& this_map, const int id);
     void AddBusBuilder(json::Builder& builder, const transport::TransportCatalogue& tc, const json::Dict& this_map, const int id);
+    void AddBusBuilder(json::Builder& builder, const transport::CatalogueSnapshot& snapshot, const json::Dict& this_map, const int id);
+    std::string GetMapSvg(const transport::TransportCatalogue& tc);
+    std::string GetMapSvg(const transport::CatalogueSnapshot& snapshot);
     void AddRouteBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router);
+    void AddRouteItems(json::Builder& builder, const RouteResult& route);
+    void AddReachableBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router);
+    void AddRouteMatrixBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router);
+    void AddRouteCacheStatsBuilder(json::Builder& builder, const int id, const TransportRouter& router);
+    void AddTravelTimeBuilder(json::Builder& builder, const json::Dict& this_map, const int id, const TransportRouter& router);
     std::ostringstream map_out_;
+    RouteResult route_buffer_;// ответ Route, переиспользуется между запросами
 };
@@ -0,0 +1,131 @@
+#include "k_shortest_paths.h"
+#include <algorithm>
+#include <set>
+#include <utility>
+
+KShortestPaths::KShortestPaths(const Graph& graph)
+    : graph_(graph)
+    , banned_vertex_(graph.GetVertexCount(), 0)
+    , banned_edge_(graph.GetEdgeCount(), 0) {
+}
+
+std::vector<std::vector<size_t>> KShortestPaths::Find(size_t source, size_t target, size_t k,
+    const std::vector<size_t>& shortest) {
+    std::vector<std::vector<size_t>> result;
+    if (k == 0) {
+        return result;
+    }
+    result.push_back(shortest);
+    std::set<std::vector<uint32_t>> signatures{ RideSignature(shortest) };
+
+    // found - все пути Йена по порядку, включая не попавшие в ответ: от них тоже идут ответвления
+    std::vector<std::vector<size_t>> found{ shortest };
+    std::set<std::vector<size_t>> seen{ shortest };
+    std::set<std::pair<double, std::vector<size_t>>> candidates;
+    std::vector<size_t> vertices;
+    std::vector<size_t> spur_path;
+    SearchWorkspace::Lease search = SearchWorkspace::Borrow(graph_.GetVertexCount());
+
+    for (size_t iteration = 0; result.size() < k && iteration < k * kCandidatesPerRoute; ++iteration) {
+        const std::vector<size_t> last = found.back();
+        vertices.assign(1, source);
+        for (size_t edge_id : last) {
+            vertices.push_back(graph_.GetEdgeTarget(edge_id));
+        }
+
+        for (size_t i = 0; i < last.size(); ++i) {
+            if (++ban_epoch_ == 0) {
+                std::fill(banned_vertex_.begin(), banned_vertex_.end(), 0);
+                std::fill(banned_edge_.begin(), banned_edge_.end(), 0);
+                ban_epoch_ = 1;
+            }
+            // ребра, которыми пути с тем же началом уходят из вершины ответвления
+            for (const auto& path : found) {
+                if (path.size() > i && std::equal(last.begin(), last.begin() + i, path.begin())) {
+                    banned_edge_[path[i]] = ban_epoch_;
+                }
+            }
+            // вершины общего начала, чтобы не было циклов
+            for (size_t j = 0; j < i; ++j) {
+                banned_vertex_[vertices[j]] = ban_epoch_;
+            }
+            if (!FindSpurPath(*search, vertices[i], target, spur_path)) {
+                continue;
+            }
+            std::vector<size_t> candidate(last.begin(), last.begin() + i);
+            candidate.insert(candidate.end(), spur_path.begin(), spur_path.end());
+            if (seen.insert(candidate).second) {
+                double time = PathTime(candidate);
+                candidates.emplace(time, std::move(candidate));
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+
+        auto best = candidates.begin();
+        found.push_back(best->second);
+        candidates.erase(best);
+        if (signatures.insert(RideSignature(found.back())).second) {
+            result.push_back(found.back());
+        }
+    }
+    return result;
+}
+
+bool KShortestPaths::FindSpurPath(SearchWorkspace& search, size_t spur, size_t target,
+    std::vector<size_t>& path_edges) {
+    path_edges.clear();
+    search.Begin(graph_.GetVertexCount());
+    LazyBinaryHeap& queue = search.Queue();
+    search.Set(spur, 0.0, SearchWorkspace::kNoEdge);
+    queue.Push(0.0, spur);
+    bool reached = false;
+    while (!queue.Empty()) {
+        auto [d, v] = queue.Pop();
+        if (d > search.Dist(v)) continue;
+        if (v == target) {
+            reached = true;
+            break;
+        }
+        for (size_t edge_id = graph_.EdgesBegin(v); edge_id < graph_.EdgesEnd(v); ++edge_id) {
+            size_t to = graph_.GetEdgeTarget(edge_id);
+            if (banned_edge_[edge_id] == ban_epoch_ || banned_vertex_[to] == ban_epoch_) {
+                continue;
+            }
+            double nd = d + graph_.GetEdgeWeight(edge_id);
+            if (nd < search.Dist(to)) {
+                search.Set(to, nd, static_cast<uint32_t>(edge_id));
+                queue.Push(nd, to);
+            }
+        }
+    }
+    if (!reached) {
+        return false;
+    }
+    for (size_t cur = target; search.PrevEdge(cur) != SearchWorkspace::kNoEdge; cur = graph_.GetEdgeSource(search.PrevEdge(cur))) {
+        path_edges.push_back(search.PrevEdge(cur));
+    }
+    std::reverse(path_edges.begin(), path_edges.end());
+    return true;
+}
+
+// в том же порядке, что и TransportRouter::SumItemTimes
+double KShortestPaths::PathTime(const std::vector<size_t>& path_edges) const {
+    double time = 0.0;
+    for (size_t edge_id : path_edges) {
+        time += graph_.GetEdgeWeight(edge_id);
+    }
+    return time;
+}
+
+std::vector<uint32_t> KShortestPaths::RideSignature(const std::vector<size_t>& path_edges) const {
+    std::vector<uint32_t> buses;
+    for (size_t edge_id : path_edges) {
+        const EdgeInfo info = graph_.GetEdgeInfo(edge_id);
+        if (!info.IsWait()) {
+            buses.push_back(info.bus_id);
+        }
+    }
+    return buses;
+}
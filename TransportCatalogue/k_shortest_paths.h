@@ -0,0 +1,35 @@
+#pragma once
+#include "graph.h"
+#include "search_workspace.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Несколько альтернативных маршрутов алгоритмом Йена над Graph.
+// Пути без циклов по вершинам (значит, и по остановкам) выдаются по возрастанию времени;
+// в ответ попадают только пути с новой последовательностью автобусов - вариант,
+// отличающийся лишь остановкой пересадки, альтернативой не считается.
+// Поиски ответвлений идут в SearchWorkspace потока, сам объект держит отметки
+// запрещенных вершин и ребер и переиспользует их между запросами; один объект - один поток.
+class KShortestPaths {
+public:
+    explicit KShortestPaths(const Graph& graph);
+
+    // shortest - ребра кратчайшего пути source -> target, он всегда первый в ответе.
+    // Возвращает до k путей (ребра в прямом порядке)
+    std::vector<std::vector<size_t>> Find(size_t source, size_t target, size_t k, const std::vector<size_t>& shortest);
+private:
+    // сколько путей Йена перебрать на один выданный, прежде чем сдаться
+    static constexpr size_t kCandidatesPerRoute = 10;
+
+    // Дейкстра spur -> target в обход запрещенных вершин и ребер текущей эпохи
+    bool FindSpurPath(SearchWorkspace& search, size_t spur, size_t target, std::vector<size_t>& path_edges);
+    double PathTime(const std::vector<size_t>& path_edges) const;
+    std::vector<uint32_t> RideSignature(const std::vector<size_t>& path_edges) const;
+
+    const Graph& graph_;
+    // отметки эпох вместо очистки массивов размером в граф
+    uint32_t ban_epoch_ = 0;
+    std::vector<uint32_t> banned_vertex_;
+    std::vector<uint32_t> banned_edge_;
+};
@@ -1,25 +1,121 @@
-﻿#include "transport_catalogue.h"
+﻿#include "catalogue_snapshot.h"
+#include "transport_catalogue.h"
 #include "json.h"
 #include "json_reader.h"
 #include "transport_router.h"
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
+using namespace std::literals;
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+}
+
+void PrintResult(const json::Node& result) {
+    std::ostringstream out;
+    json::Print(json::Document(result), out);
+    std::cout << out.str() << "\n";
+}
+
+// make_base: сохраняет роутер в serialization_settings.file,
+// а снимок каталога с картой - в serialization_settings.catalogue_file
+int MakeBase(const json::Node& root) {
+    JsonReader json_reader;
+    std::string router_file = json_reader.ReadSerializationFile(root);
+    std::string catalogue_file = json_reader.ReadSerializationFile(root, "catalogue_file"sv);
+    if (router_file.empty() && catalogue_file.empty()) {
+        std::cerr << "serialization_settings.file is not set\n"sv;
+        return 1;
+    }
+    const RouterSettings settings = json_reader.ReadRouterSettings(root);
+    // режим проверяется до построения: иначе полный предрасчет уходит впустую,
+    // а на диске остается база из одного снимка каталога
+    if (!router_file.empty() && !TransportRouter::CanSave(settings.mode)) {
+        std::cerr << "route_patterns mode cannot be saved\n"sv;
+        return 1;
+    }
 
-int main() {
     transport::TransportCatalogue tc;
-    std::istream& in = std::cin;
-    json::Document doc = json::Load(in);
-    const json::Node& root = doc.GetRoot();
+    json_reader.ReadAndExecuteBaseRequests(tc, root);
+    if (!router_file.empty()) {
+        TransportRouter router(tc, settings);
+        router.Save(router_file);
+    }
+    if (!catalogue_file.empty()) {
+        transport::CatalogueSnapshot::Write(tc, json_reader.GetMap().str(), catalogue_file);
+    }
+    return 0;
+}
 
+// process_requests: роутер читается из файла; Bus/Stop/Map отвечает снимок каталога,
+// если он задан, иначе каталог строится из base_requests
+int ProcessRequests(const json::Node& root) {
     JsonReader json_reader;
+    std::string file = json_reader.ReadSerializationFile(root);
+    if (file.empty()) {
+        std::cerr << "serialization_settings.file is not set\n"sv;
+        return 1;
+    }
+    std::string catalogue_file = json_reader.ReadSerializationFile(root, "catalogue_file"sv);
+    // снимок только для чтения: изменения не к чему применить, молча отвечать по старым данным нельзя
+    if (!catalogue_file.empty() && json_reader.HasUpdateRequests(root)) {
+        std::cerr << "update_requests cannot be applied with serialization_settings.catalogue_file\n"sv;
+        return 1;
+    }
+    std::unique_ptr<TransportRouter> router = TransportRouter::Load(file);
+    // кэш ответов - настройка процесса, а не базы, поэтому берется из этого запроса
+    router->SetResultCacheCapacity(json_reader.ReadRouterSettings(root).result_cache_entries);
+    // ожидание и скорость тоже: другой сценарий не требует новой базы, граф хранит расстояния
+    router->SetEdgeWeights(json_reader.ReadEdgeWeights(root, router->GetEdgeWeights()));
+
+    if (!catalogue_file.empty()) {
+        transport::CatalogueSnapshot snapshot(catalogue_file);
+        PrintResult(json_reader.ExecuteStatRequests(snapshot, root, *router));
+        return 0;
+    }
+
+    transport::TransportCatalogue tc;
     json_reader.ReadAndExecuteBaseRequests(tc, root);
+    json_reader.ApplyUpdateRequests(tc, root, *router);
+    PrintResult(json_reader.ExecuteStatRequests(tc, root, *router));
+    return 0;
+}
 
-    TransportRouter router(tc);
+// без аргументов - все в одном процессе, как раньше
+int ProcessAll(const json::Node& root) {
+    transport::TransportCatalogue tc;
+    JsonReader json_reader;
+    json_reader.ReadAndExecuteBaseRequests(tc, root);
 
-    json::Node result = json_reader.ExecuteStatRequests(tc, root, router);
-    std::ostringstream out;
-    json::Print(json::Document(result), out);
-    std::cout << out.str() << "\n";
+    TransportRouter router(tc, json_reader.ReadRouterSettings(root));
+    json_reader.ApplyUpdateRequests(tc, root, router);
+    PrintResult(json_reader.ExecuteStatRequests(tc, root, router));
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    const std::string_view mode = argc == 2 ? std::string_view(argv[1]) : std::string_view{};
+    if (argc > 2 || (argc == 2 && mode != "make_base"sv && mode != "process_requests"sv)) {
+        PrintUsage();
+        return 1;
+    }
+    json::Document doc = json::Load(std::cin);
+    const json::Node& root = doc.GetRoot();
+
+    // неверные данные (например, расписание) - сообщение и код 1 в любом режиме
+    try {
+        if (mode.empty()) {
+            return ProcessAll(root);
+        }
+        return mode == "make_base"sv ? MakeBase(root) : ProcessRequests(root);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n"sv;
+        return 1;
+    }
+}
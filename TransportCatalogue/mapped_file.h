@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Файл, открытый только на чтение и отображенный в память.
+// На POSIX - mmap(PROT_READ, MAP_SHARED): страницы подгружаются по обращению и
+// общие для всех процессов, открывших тот же файл. В остальных системах файл
+// целиком читается в память (тот же интерфейс, без разделения страниц).
+// Ошибки открытия - std::runtime_error.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* GetData() const {
+        return data_;
+    }
+    size_t GetSize() const {
+        return size_;
+    }
+    bool IsMapped() const {
+        return mapped_;
+    }
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;// запасной вариант без mmap
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Очереди с приоритетом для Дейкстры в Graph.
+// Общий интерфейс: Reset(vertex_count), Empty(), Push(key, v), Pop() -> {key, v}.
+// Push для уже лежащей в очереди вершины либо уменьшает ключ, либо кладет дубль -
+// поиск в любом случае пропускает записи с ключом больше текущего dist[v].
+// Все очереди извлекают минимум по паре (ключ, вершина), поэтому порядок
+// обработки вершин и построенные деревья у них совпадают.
+
+enum class QueueKind {
+    BinaryHeap,    // двоичная куча с ленивым удалением, дубль на каждую релаксацию
+    QuaternaryHeap,// 4-арная куча с уменьшением ключа, каждая вершина не больше одного раза
+    RadixHeap,     // radix heap над временем в фиксированной точке
+};
+
+// Двоичная куча над std::vector, тот же порядок, что у std::priority_queue с std::greater
+class LazyBinaryHeap {
+public:
+    void Reset(size_t /*vertex_count*/) {
+        heap_.clear();
+    }
+    bool Empty() const {
+        return heap_.empty();
+    }
+    // минимум без извлечения, нужен двунаправленному поиску
+    const std::pair<double, size_t>& Top() const {
+        return heap_.front();
+    }
+    void Push(double key, size_t v) {
+        heap_.push_back({ key, v });
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<Item>{});
+    }
+    std::pair<double, size_t> Pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<Item>{});
+        Item top = heap_.back();
+        heap_.pop_back();
+        return top;
+    }
+private:
+    using Item = std::pair<double, size_t>;
+    std::vector<Item> heap_;
+};
+
+// 4-арная куча с позициями вершин: вдвое ниже двоичной, а дети одного узла
+// лежат рядом в памяти
+class QuaternaryHeap {
+public:
+    void Reset(size_t vertex_count) {
+        heap_.clear();
+        // после полного опустошения все позиции уже kAbsent, чистим только новые
+        position_.resize(vertex_count, kAbsent);
+    }
+    bool Empty() const {
+        return heap_.empty();
+    }
+    void Push(double key, size_t v) {
+        uint32_t pos = position_[v];
+        if (pos == kAbsent) {
+            pos = static_cast<uint32_t>(heap_.size());
+            heap_.push_back({ key, static_cast<uint32_t>(v) });
+        }
+        else if (key < heap_[pos].key) {
+            heap_[pos].key = key;
+        }
+        else {
+            return;
+        }
+        SiftUp(pos);
+    }
+    std::pair<double, size_t> Pop() {
+        Item top = heap_.front();
+        position_[top.vertex] = kAbsent;
+        Item last = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty()) {
+            heap_.front() = last;
+            position_[last.vertex] = 0;
+            SiftDown(0);
+        }
+        return { top.key, top.vertex };
+    }
+private:
+    static constexpr uint32_t kAbsent = UINT32_MAX;
+    static constexpr size_t kArity = 4;
+
+    struct Item {
+        double key;
+        uint32_t vertex;
+        bool operator<(const Item& other) const {
+            return key < other.key || (key == other.key && vertex < other.vertex);
+        }
+    };
+
+    void SiftUp(uint32_t pos) {
+        Item item = heap_[pos];
+        while (pos > 0) {
+            uint32_t parent = (pos - 1) / kArity;
+            if (!(item < heap_[parent])) {
+                break;
+            }
+            heap_[pos] = heap_[parent];
+            position_[heap_[pos].vertex] = pos;
+            pos = parent;
+        }
+        heap_[pos] = item;
+        position_[item.vertex] = pos;
+    }
+    void SiftDown(uint32_t pos) {
+        Item item = heap_[pos];
+        const size_t size = heap_.size();
+        while (true) {
+            size_t first = pos * kArity + 1;
+            if (first >= size) {
+                break;
+            }
+            size_t best = first;
+            size_t last = std::min(first + kArity, size);
+            for (size_t child = first + 1; child < last; ++child) {
+                if (heap_[child] < heap_[best]) {
+                    best = child;
+                }
+            }
+            if (!(heap_[best] < item)) {
+                break;
+            }
+            heap_[pos] = heap_[best];
+            position_[heap_[pos].vertex] = pos;
+            pos = static_cast<uint32_t>(best);
+        }
+        heap_[pos] = item;
+        position_[item.vertex] = pos;
+    }
+
+    std::vector<Item> heap_;
+    std::vector<uint32_t> position_;// вершина -> индекс в heap_ или kAbsent
+};
+
+// Монотонная radix heap. Ключ переводится в фиксированную точку (1/2^20 минуты),
+// запись попадает в корзину по старшему биту, в котором ее ключ отличается от
+// последнего извлеченного. Работает, пока ключи не убывают - у Дейкстры с
+// неотрицательными весами это так. Внутри корзины 0 (ключ в фиксированной точке
+// равен последнему) минимум ищется по точному ключу, так что порядок извлечения
+// точный, несмотря на округление.
+class RadixHeap {
+public:
+    void Reset(size_t /*vertex_count*/) {
+        for (auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        size_ = 0;
+        last_ = 0;
+    }
+    bool Empty() const {
+        return size_ == 0;
+    }
+    void Push(double key, size_t v) {
+        Item item{ ToFixed(key), key, static_cast<uint32_t>(v) };
+        buckets_[BucketOf(item.fixed)].push_back(item);
+        ++size_;
+    }
+    std::pair<double, size_t> Pop() {
+        if (buckets_[0].empty()) {
+            Redistribute();
+        }
+        auto& bucket = buckets_[0];
+        auto best = std::min_element(bucket.begin(), bucket.end(), [](const Item& lhs, const Item& rhs) {
+            return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.vertex < rhs.vertex);
+        });
+        Item top = *best;
+        *best = bucket.back();
+        bucket.pop_back();
+        --size_;
+        return { top.key, top.vertex };
+    }
+private:
+    static constexpr double kScale = 1048576.0;// 2^20 делений на минуту
+    static constexpr size_t kBucketCount = 65;
+
+    struct Item {
+        uint64_t fixed;
+        double key;
+        uint32_t vertex;
+    };
+
+    static uint64_t ToFixed(double key) {
+        return static_cast<uint64_t>(std::floor(key * kScale));
+    }
+    size_t BucketOf(uint64_t fixed) const {
+        return fixed == last_ ? 0 : static_cast<size_t>(std::bit_width(fixed ^ last_));
+    }
+    // переносит самую младшую непустую корзину в младшие, начиная счет от ее минимума
+    void Redistribute() {
+        size_t i = 1;
+        while (buckets_[i].empty()) {
+            ++i;
+        }
+        auto& bucket = buckets_[i];
+        last_ = std::min_element(bucket.begin(), bucket.end(), [](const Item& lhs, const Item& rhs) {
+            return lhs.fixed < rhs.fixed;
+        })->fixed;
+        for (const Item& item : bucket) {
+            buckets_[BucketOf(item.fixed)].push_back(item);
+        }
+        bucket.clear();
+    }
+
+    std::vector<Item> buckets_[kBucketCount];
+    size_t size_ = 0;
+    uint64_t last_ = 0;
+};
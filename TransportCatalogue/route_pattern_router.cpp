@@ -0,0 +1,219 @@
+#include "route_pattern_router.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    constexpr uint32_t kNoPattern = std::numeric_limits<uint32_t>::max();
+}
+
+void RoutePatternRouter::Build(const transport::TransportCatalogue& tc, const Graph& graph) {
+    weights_ = EdgeWeights::FromSettings(tc.GetWaitTime(), tc.GetVelocity());
+    stop_count_ = graph.GetStopCount();
+    patterns_.clear();
+    pattern_stops_.clear();
+    prefix_distance_.clear();
+
+    // порядок обхода совпадает с Graph::BuildStopIndex, поэтому номера автобусов общие
+    uint32_t bus_id = 0;
+    for (const auto& [bus_name, bus] : *tc.GetBuses()) {
+        AddPattern(tc, graph, bus_id, bus.route, false);
+        if (!bus.is_ring) {
+            AddPattern(tc, graph, bus_id, bus.route, true);
+        }
+        ++bus_id;
+    }
+
+    // остановка -> шаблоны через нее, каждый шаблон по одному разу
+    stop_pattern_offsets_.assign(stop_count_ + 1, 0);
+    std::vector<uint32_t> last_pattern(stop_count_, kNoPattern);
+    for (uint32_t p = 0; p < patterns_.size(); ++p) {
+        for (uint32_t pos = 0; pos < patterns_[p].size; ++pos) {
+            uint32_t stop = pattern_stops_[patterns_[p].first + pos];
+            if (last_pattern[stop] != p) {
+                last_pattern[stop] = p;
+                ++stop_pattern_offsets_[stop + 1];
+            }
+        }
+    }
+    for (size_t s = 0; s < stop_count_; ++s) {
+        stop_pattern_offsets_[s + 1] += stop_pattern_offsets_[s];
+    }
+    stop_patterns_.resize(stop_pattern_offsets_[stop_count_]);
+    std::vector<uint32_t> cursor(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+    std::fill(last_pattern.begin(), last_pattern.end(), kNoPattern);
+    for (uint32_t p = 0; p < patterns_.size(); ++p) {
+        for (uint32_t pos = 0; pos < patterns_[p].size; ++pos) {
+            uint32_t stop = pattern_stops_[patterns_[p].first + pos];
+            if (last_pattern[stop] != p) {
+                last_pattern[stop] = p;
+                stop_patterns_[cursor[stop]++] = p;
+            }
+        }
+    }
+}
+
+void RoutePatternRouter::AddPattern(const transport::TransportCatalogue& tc, const Graph& graph,
+    uint32_t bus_id, const std::vector<std::string>& route, bool reverse) {
+    if (route.size() < 2) {
+        return;
+    }
+    Pattern pattern{ bus_id, static_cast<uint32_t>(pattern_stops_.size()), static_cast<uint32_t>(route.size()) };
+    double distance = 0.0;
+    for (size_t pos = 0; pos < route.size(); ++pos) {
+        size_t idx = reverse ? route.size() - 1 - pos : pos;
+        if (pos > 0) {
+            size_t prev_idx = reverse ? idx + 1 : idx - 1;
+            distance += tc.GetRoadDistance(route[prev_idx], route[idx]);
+        }
+        pattern_stops_.push_back(static_cast<uint32_t>(graph.GetStopToIndex().at(route[idx])));
+        prefix_distance_.push_back(distance);
+    }
+    patterns_.push_back(pattern);
+}
+
+std::optional<RoutePatternRouter::Journey> RoutePatternRouter::FindJourney(size_t from_stop, size_t to_stop) const {
+    return FindJourney(from_stop, to_stop, weights_);
+}
+
+std::optional<RoutePatternRouter::Journey> RoutePatternRouter::FindJourney(size_t from_stop, size_t to_stop,
+    const EdgeWeights& weights) const {
+    SearchState state;
+    state.weights = weights;
+    RunRounds(from_stop, to_stop, std::numeric_limits<double>::infinity(), kAllRounds, state);
+    if (state.best[to_stop] == std::numeric_limits<double>::infinity()) {
+        return std::nullopt;
+    }
+    return BuildJourney(state, to_stop, state.arrival.size() - 1);
+}
+
+std::vector<RoutePatternRouter::Journey> RoutePatternRouter::FindParetoJourneys(size_t from_stop, size_t to_stop,
+    size_t max_rides) const {
+    SearchState state;
+    state.weights = weights_;
+    RunRounds(from_stop, to_stop, std::numeric_limits<double>::infinity(), max_rides, state);
+    // отсечение по цели оставляет улучшение в раунде, только если оно строгое
+    std::vector<Journey> front;
+    for (size_t round = 1; round < state.arrival.size(); ++round) {
+        if (state.parents[round][to_stop].pattern != kNoPattern) {
+            front.push_back(BuildJourney(state, to_stop, round));
+        }
+    }
+    return front;
+}
+
+RoutePatternRouter::Journey RoutePatternRouter::BuildJourney(const SearchState& state, size_t to_stop, size_t round) const {
+    Journey journey;
+    journey.total_time = state.arrival[round][to_stop];
+    size_t stop = to_stop;
+    for (; round > 0; --round) {
+        const Parent& parent = state.parents[round][stop];
+        if (parent.pattern == kNoPattern) {
+            continue;
+        }
+        const Pattern& pattern = patterns_[parent.pattern];
+        double ride_time = (prefix_distance_[pattern.first + parent.alight_pos]
+            - prefix_distance_[pattern.first + parent.board_pos]) / state.weights.speed_m_per_min;
+        stop = pattern_stops_[pattern.first + parent.board_pos];
+        journey.legs.push_back(Leg{ static_cast<uint32_t>(stop), pattern.bus_id,
+            parent.alight_pos - parent.board_pos, ride_time });
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+std::vector<double> RoutePatternRouter::FindArrivalTimes(size_t from_stop, double time_limit) const {
+    SearchState state;
+    state.weights = weights_;
+    RunRounds(from_stop, kNoStop, time_limit, kAllRounds, state);
+    return std::move(state.best);
+}
+
+void RoutePatternRouter::RunRounds(size_t from_stop, size_t to_stop, double time_limit, size_t max_rounds,
+    SearchState& state) const {
+    const double INF = std::numeric_limits<double>::infinity();
+    const double wait_time = state.weights.wait_time;
+    const double speed_m_per_min = state.weights.speed_m_per_min;
+
+    // arrival[k][s] - лучшее время прибытия в s не более чем за k поездок
+    auto& arrival = state.arrival;
+    auto& parents = state.parents;
+    auto& best = state.best;
+    arrival.assign(1, std::vector<double>(stop_count_, INF));
+    parents.assign(1, std::vector<Parent>(stop_count_, Parent{ kNoPattern, 0, 0 }));
+    best.assign(stop_count_, INF);
+    arrival[0][from_stop] = 0.0;
+    best[from_stop] = 0.0;
+
+    std::vector<uint32_t> marked_stops{ static_cast<uint32_t>(from_stop) };
+    std::vector<char> is_marked(stop_count_, 0);
+    // для каждого шаблона - первая позиция, с которой его нужно просматривать
+    std::vector<uint32_t> scan_from(patterns_.size(), kNoPattern);
+    std::vector<uint32_t> queued_patterns;
+
+    while (!marked_stops.empty() && arrival.size() <= max_rounds) {
+        for (uint32_t stop : marked_stops) {
+            is_marked[stop] = 0;
+            for (uint32_t i = stop_pattern_offsets_[stop]; i < stop_pattern_offsets_[stop + 1]; ++i) {
+                uint32_t p = stop_patterns_[i];
+                const Pattern& pattern = patterns_[p];
+                const uint32_t* stops = &pattern_stops_[pattern.first];
+                uint32_t pos = static_cast<uint32_t>(std::find(stops, stops + pattern.size, stop) - stops);
+                if (scan_from[p] == kNoPattern) {
+                    queued_patterns.push_back(p);
+                    scan_from[p] = pos;
+                }
+                else {
+                    scan_from[p] = std::min(scan_from[p], pos);
+                }
+            }
+        }
+        marked_stops.clear();
+
+        size_t round = arrival.size();
+        arrival.push_back(arrival.back());
+        parents.emplace_back(stop_count_, Parent{ kNoPattern, 0, 0 });
+        const std::vector<double>& prev_arrival = arrival[round - 1];
+        std::vector<double>& cur_arrival = arrival[round];
+        std::vector<Parent>& cur_parents = parents[round];
+
+        for (uint32_t p : queued_patterns) {
+            const Pattern& pattern = patterns_[p];
+            bool boarded = false;
+            uint32_t board_pos = 0;
+            double board_time = 0.0;// момент посадки, включая ожидание
+            double board_key = 0.0; // board_time - prefix: чем меньше, тем раньше приедем дальше
+
+            for (uint32_t pos = scan_from[p]; pos < pattern.size; ++pos) {
+                uint32_t stop = pattern_stops_[pattern.first + pos];
+                double prefix = prefix_distance_[pattern.first + pos];
+                if (boarded) {
+                    double ride_time = (prefix - prefix_distance_[pattern.first + board_pos]) / speed_m_per_min;
+                    double arrive = board_time + ride_time;
+                    // без цели (kNoStop) отсекать нечем, считаем время до всех остановок
+                    double bound = to_stop == kNoStop ? best[stop] : std::min(best[stop], best[to_stop]);
+                    if (arrive < bound && arrive <= time_limit) {
+                        cur_arrival[stop] = arrive;
+                        best[stop] = arrive;
+                        cur_parents[stop] = Parent{ p, board_pos, pos };
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = 1;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                if (prev_arrival[stop] < INF) {
+                    double time = prev_arrival[stop] + wait_time;
+                    double key = time - prefix / speed_m_per_min;
+                    if (!boarded || key < board_key) {
+                        boarded = true;
+                        board_pos = pos;
+                        board_time = time;
+                        board_key = key;
+                    }
+                }
+            }
+            scan_from[p] = kNoPattern;
+        }
+        queued_patterns.clear();
+    }
+}
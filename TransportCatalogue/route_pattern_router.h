@@ -0,0 +1,92 @@
+#pragma once
+#include "graph.h"
+#include "transport_catalogue.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Поиск маршрутов без квадратичного графа: каждый автобус хранится как
+// последовательность остановок (шаблон маршрута) с префиксными суммами расстояний,
+// поиск идет раундами в стиле RAPTOR, раунд k - маршруты ровно из k поездок.
+// Время поездки считается как (prefix[j] - prefix[i]) / скорость: расстояния целые,
+// поэтому результат совпадает с весами ребер Graph бит в бит.
+class RoutePatternRouter {
+public:
+    struct Leg {
+        uint32_t board_stop;
+        uint32_t bus_id;
+        uint32_t span_count;
+        double ride_time;
+    };
+
+    struct Journey {
+        double total_time = 0.0;
+        std::vector<Leg> legs;
+    };
+
+    // Индексы остановок и автобусов берутся из graph (см. Graph::BuildStopIndex)
+    void Build(const transport::TransportCatalogue& tc, const Graph& graph);
+
+    double GetWaitTime() const {
+        return weights_.wait_time;
+    }
+    const EdgeWeights& GetEdgeWeights() const {
+        return weights_;
+    }
+    // Шаблоны хранят расстояния, поэтому новые настройки применяются без перестройки
+    void SetEdgeWeights(const EdgeWeights& weights) {
+        weights_ = weights;
+    }
+    std::optional<Journey> FindJourney(size_t from_stop, size_t to_stop) const;
+    // То же при других настройках ожидания и скорости
+    std::optional<Journey> FindJourney(size_t from_stop, size_t to_stop, const EdgeWeights& weights) const;
+    // Парето-фронт по (время, число поездок): маршруты по возрастанию числа поездок,
+    // каждый строго быстрее предыдущего, не больше max_rides поездок
+    std::vector<Journey> FindParetoJourneys(size_t from_stop, size_t to_stop, size_t max_rides) const;
+    // Время до всех остановок из from_stop за один проход раундов, бесконечность - недостижимо
+    // или дольше time_limit (дальше лимита поиск не идет)
+    std::vector<double> FindArrivalTimes(size_t from_stop,
+        double time_limit = std::numeric_limits<double>::infinity()) const;
+private:
+    static constexpr size_t kNoStop = std::numeric_limits<size_t>::max();
+    static constexpr size_t kAllRounds = std::numeric_limits<size_t>::max();
+
+    struct Pattern {
+        uint32_t bus_id;
+        uint32_t first;// начало в pattern_stops_/prefix_distance_
+        uint32_t size;
+    };
+    // откуда пришли в остановку в данном раунде
+    struct Parent {
+        uint32_t pattern;
+        uint32_t board_pos;// позиции в шаблоне
+        uint32_t alight_pos;
+    };
+
+    struct SearchState {
+        EdgeWeights weights;// настройки, при которых идет поиск
+        std::vector<std::vector<double>> arrival;
+        std::vector<std::vector<Parent>> parents;
+        std::vector<double> best;
+    };
+
+    // раунды из from_stop; to_stop == kNoStop - без отсечения по цели,
+    // прибытия позже time_limit отбрасываются, раундов не больше max_rounds
+    void RunRounds(size_t from_stop, size_t to_stop, double time_limit, size_t max_rounds, SearchState& state) const;
+    // маршрут до to_stop по родителям раундов не старше round
+    Journey BuildJourney(const SearchState& state, size_t to_stop, size_t round) const;
+    void AddPattern(const transport::TransportCatalogue& tc, const Graph& graph,
+        uint32_t bus_id, const std::vector<std::string>& route, bool reverse);
+
+    EdgeWeights weights_;
+    size_t stop_count_ = 0;
+
+    std::vector<Pattern> patterns_;
+    std::vector<uint32_t> pattern_stops_;
+    std::vector<double> prefix_distance_;// сумма расстояний от начала шаблона, м
+    // шаблоны через остановку: [stop_pattern_offsets_[s], stop_pattern_offsets_[s + 1])
+    std::vector<uint32_t> stop_pattern_offsets_;
+    std::vector<uint32_t> stop_patterns_;
+};
@@ -0,0 +1,79 @@
+#include "route_result_cache.h"
+#include "transport_router.h"
+#include <algorithm>
+
+RouteResultCache::RouteResultCache(size_t capacity, size_t shard_count)
+    : capacity_(capacity) {
+    shard_count = std::max<size_t>(1, std::min(shard_count, capacity));
+    shard_capacity_ = (capacity + shard_count - 1) / shard_count;
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+uint64_t RouteResultCache::MakeKey(size_t from_idx, size_t to_idx) {
+    return (static_cast<uint64_t>(from_idx) << 32) | static_cast<uint32_t>(to_idx);
+}
+
+RouteResultCache::Shard& RouteResultCache::GetShard(uint64_t key) {
+    // перемешиваем, чтобы соседние пары остановок попадали в разные шарды
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    return *shards_[(hash >> 32) % shards_.size()];
+}
+
+std::shared_ptr<const RouteResult> RouteResultCache::Find(size_t from_idx, size_t to_idx) {
+    const uint64_t key = MakeKey(from_idx, to_idx);
+    Shard& shard = GetShard(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second->result;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void RouteResultCache::Insert(size_t from_idx, size_t to_idx, std::shared_ptr<const RouteResult> result) {
+    if (capacity_ == 0) {
+        return;
+    }
+    const uint64_t key = MakeKey(from_idx, to_idx);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.index.count(key)) {
+        return;
+    }
+    shard.entries.push_front(Entry{ key, std::move(result) });
+    shard.index[key] = shard.entries.begin();
+    while (shard.entries.size() > shard_capacity_) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RouteResultCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->index.clear();
+    }
+}
+
+RouteResultCache::Stats RouteResultCache::GetStats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.capacity = capacity_ == 0 ? 0 : shard_capacity_ * shards_.size();
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.size += shard->entries.size();
+    }
+    return stats;
+}
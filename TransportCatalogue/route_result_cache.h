@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct RouteResult;
+
+// Кэш готовых ответов Route, ключ - пара индексов остановок (from, to).
+// Ключи разложены по шардам, у каждого шарда свой мьютекс и своя LRU-очередь,
+// поэтому параллельные запросы к разным парам почти не ждут друг друга.
+// Вместимость - число ответов на весь кэш, делится между шардами поровну
+// (с округлением вверх, фактическая вместимость - в Stats::capacity).
+class RouteResultCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    explicit RouteResultCache(size_t capacity, size_t shard_count = 16);
+
+    // Ответ или nullptr; учитывается как попадание или промах
+    std::shared_ptr<const RouteResult> Find(size_t from_idx, size_t to_idx);
+    // Если ответ уже положил другой поток, остается прежний
+    void Insert(size_t from_idx, size_t to_idx, std::shared_ptr<const RouteResult> result);
+    // Убирает все ответы, счетчики сохраняются
+    void Clear();
+    Stats GetStats() const;
+private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const RouteResult> result;
+    };
+    // шард на своей строке кэша, чтобы мьютексы соседей не делили ее
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;// в начале - самые свежие
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    static uint64_t MakeKey(size_t from_idx, size_t to_idx);
+    Shard& GetShard(uint64_t key);
+
+    size_t capacity_;
+    size_t shard_capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> evictions_{ 0 };
+};
@@ -0,0 +1,85 @@
+#include "route_table.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+constexpr size_t kHugePage = size_t{ 2 } * 1024 * 1024;
+
+size_t RoundUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+RouteTable::~RouteTable() {
+    Release();
+}
+
+void RouteTable::Reset(size_t rows, size_t columns, bool huge_pages) {
+    Release();
+    rows_ = rows;
+    columns_ = columns;
+    size_t bytes = rows * columns * sizeof(RouteCell);
+    if (bytes == 0) {
+        return;
+    }
+
+#ifdef __linux__
+    huge_pages_ = huge_pages;
+#else
+    huge_pages_ = false;
+    (void)huge_pages;
+#endif
+    alignment_ = huge_pages_ ? kHugePage : kCacheLine;
+    bytes_ = RoundUp(bytes, alignment_);
+    cells_ = static_cast<RouteCell*>(::operator new(bytes_, std::align_val_t{ alignment_ }));
+    view_ = cells_;
+
+#ifdef __linux__
+    // совет нужно дать до первой записи, пока страницы еще не выделены;
+    // если ядро без THP, madvise вернет ошибку и блок останется на обычных страницах
+    if (huge_pages_ && madvise(cells_, bytes_, MADV_HUGEPAGE) != 0) {
+        huge_pages_ = false;
+    }
+#endif
+}
+
+void RouteTable::Attach(const RouteCell* cells, size_t rows, size_t columns, std::shared_ptr<const MappedFile> file) {
+    Release();
+    view_ = cells;
+    rows_ = rows;
+    columns_ = columns;
+    file_ = std::move(file);
+}
+
+void RouteTable::Detach() {
+    if (cells_ || !view_) {
+        return;
+    }
+    const RouteCell* source = view_;
+    std::shared_ptr<const MappedFile> file = std::move(file_);
+    size_t rows = rows_;
+    size_t columns = columns_;
+    view_ = nullptr;
+    Reset(rows, columns, false);
+    std::copy(source, source + rows * columns, cells_);
+}
+
+void RouteTable::Release() {
+    if (cells_) {
+        ::operator delete(cells_, std::align_val_t{ alignment_ });
+    }
+    cells_ = nullptr;
+    view_ = nullptr;
+    file_.reset();
+    rows_ = columns_ = bytes_ = alignment_ = 0;
+    huge_pages_ = false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+class MappedFile;
+
+// Таблица предвычисленных маршрутов одним непрерывным блоком.
+// Строка - остановка-источник, столбец - вершина графа. Время и ребро, по которому
+// пришли, лежат рядом, поэтому ответ на запрос читает одну строку подряд.
+// 8 байт на ячейку вместо 12 у пары vector<double>/vector<int>; точное время
+// маршрута роутер пересчитывает по ребрам пути, float нужен только для выбора
+// конечной вершины.
+struct RouteCell {
+    static constexpr uint32_t kNoEdge = std::numeric_limits<uint32_t>::max();
+
+    float dist;        // мин время, бесконечность - недостижимо
+    uint32_t prev_edge;// ребро, по которому пришли, kNoEdge у источника и недостижимых
+};
+
+class RouteTable {
+public:
+    RouteTable() = default;
+    RouteTable(const RouteTable&) = delete;
+    RouteTable& operator=(const RouteTable&) = delete;
+    ~RouteTable();
+
+    // Выделяет неинициализированную таблицу rows x columns.
+    // huge_pages - выровнять блок по 2 МБ и попросить у ядра большие страницы
+    // (только Linux, в остальных системах флаг игнорируется)
+    void Reset(size_t rows, size_t columns, bool huge_pages);
+    // Подключает готовую таблицу из отображенного файла без копирования.
+    // Такая таблица только для чтения, file держит отображение живым
+    void Attach(const RouteCell* cells, size_t rows, size_t columns, std::shared_ptr<const MappedFile> file);
+    // Копирует подключенную таблицу в свой блок, чтобы ее можно было менять
+    void Detach();
+
+    // строка для заполнения, только у таблицы после Reset
+    RouteCell* Row(size_t row) {
+        return cells_ + row * columns_;
+    }
+    const RouteCell* Row(size_t row) const {
+        return view_ + row * columns_;
+    }
+    bool Empty() const {
+        return view_ == nullptr;
+    }
+    size_t GetRowCount() const {
+        return rows_;
+    }
+    size_t GetColumnCount() const {
+        return columns_;
+    }
+    size_t ByteSize() const {
+        return bytes_;
+    }
+    bool IsHugePageBacked() const {
+        return huge_pages_;
+    }
+private:
+    void Release();
+
+    RouteCell* cells_ = nullptr;// свой блок, nullptr у подключенной таблицы
+    const RouteCell* view_ = nullptr;// данные для чтения: cells_ или место в файле
+    std::shared_ptr<const MappedFile> file_;
+    size_t rows_ = 0;
+    size_t columns_ = 0;
+    size_t bytes_ = 0;// размер выделенного блока, кратен выравниванию
+    size_t alignment_ = 0;
+    bool huge_pages_ = false;
+};
@@ -0,0 +1,50 @@
+#include "route_tree_cache.h"
+
+RouteTreeCache::RouteTreeCache(size_t budget_bytes) : budget_bytes_(budget_bytes) {
+}
+
+std::shared_ptr<const ShortestPathTree> RouteTreeCache::Find(size_t stop_idx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(stop_idx);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->tree;
+}
+
+std::shared_ptr<const ShortestPathTree> RouteTreeCache::Insert(size_t stop_idx, ShortestPathTree tree) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(stop_idx);
+    if (it != index_.end()) {
+        // дерево уже успел посчитать другой поток
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->tree;
+    }
+    size_t bytes = tree.ByteSize();
+    auto ptr = std::make_shared<const ShortestPathTree>(std::move(tree));
+    entries_.push_front(Entry{ stop_idx, ptr, bytes });
+    index_[stop_idx] = entries_.begin();
+    used_bytes_ += bytes;
+    EvictOverBudget();
+    return ptr;
+}
+
+size_t RouteTreeCache::GetUsedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_bytes_;
+}
+
+size_t RouteTreeCache::GetSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void RouteTreeCache::EvictOverBudget() {
+    while (used_bytes_ > budget_bytes_ && entries_.size() > 1) {
+        const Entry& last = entries_.back();
+        used_bytes_ -= last.bytes;
+        index_.erase(last.stop_idx);
+        entries_.pop_back();
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "graph.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// LRU-кэш деревьев кратчайших путей, ключ - индекс остановки-источника.
+// Размер ограничен суммарным объемом деревьев в байтах.
+class RouteTreeCache {
+public:
+    explicit RouteTreeCache(size_t budget_bytes);
+
+    // Возвращает дерево и поднимает его в начало очереди, либо nullptr
+    std::shared_ptr<const ShortestPathTree> Find(size_t stop_idx);
+    // Кладет дерево в кэш, вытесняя самые старые, пока не влезем в бюджет.
+    // Последнее добавленное дерево не вытесняется, даже если оно больше бюджета.
+    std::shared_ptr<const ShortestPathTree> Insert(size_t stop_idx, ShortestPathTree tree);
+
+    size_t GetUsedBytes() const;
+    size_t GetSize() const;
+private:
+    struct Entry {
+        size_t stop_idx;
+        std::shared_ptr<const ShortestPathTree> tree;
+        size_t bytes;
+    };
+
+    void EvictOverBudget();
+
+    size_t budget_bytes_;
+    size_t used_bytes_ = 0;
+    std::list<Entry> entries_;// в начале - самые свежие
+    std::unordered_map<size_t, std::list<Entry>::iterator> index_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,191 @@
+#include "graph.h"
+#include "json.h"
+#include "json_reader.h"
+#include "priority_queues.h"
+#include "stop_order.h"
+#include "transport_catalogue.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Сравнение очередей Дейкстры и нумераций остановок на реальной базе.
+// Запуск: router_benchmark [input.json] [повторы] [источники]; без файла база читается из stdin.
+// Для каждой очереди считаются деревья из всех остановок (или из равномерной выборки
+// заданного размера, одной и той же по именам при любой нумерации) в одном потоке.
+// Печатается, сколько ребер убирает SetDropDominatedEdges.
+// Нумерации сравниваются на двоичной куче: время, промахи кэша последнего уровня
+// (счетчик perf, только Linux, если ядро его дает) и средний разрыв номеров концов ребра.
+
+namespace {
+
+struct BenchResult {
+    double millis = 0.0;
+    double checksum = 0.0;// сумма конечных расстояний, должна совпасть у всех очередей
+    long long cache_misses = -1;// на один прогон, -1 - счетчик недоступен
+};
+
+// Промахи кэша последнего уровня текущего потока
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    void Start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    // -1, если счетчик открыть не удалось
+    long long Stop() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if (read(fd_, &count, sizeof(count)) == sizeof(count)) {
+                return count;
+            }
+        }
+#endif
+        return -1;
+    }
+private:
+    int fd_ = -1;
+};
+
+template <typename Queue>
+BenchResult RunQueue(const Graph& graph, const std::vector<std::string>& sources, int repeats) {
+    std::vector<double> dist(graph.GetVertexCount());
+    std::vector<int> prev_e(graph.GetVertexCount());
+    Queue queue;
+    BenchResult result;
+
+    CacheMissCounter counter;
+    counter.Start();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        result.checksum = 0.0;
+        for (const std::string& source : sources) {
+            graph.ComputeShortestPaths(graph.GetStopToIndex().at(source), dist.data(), prev_e.data(), queue);
+            for (double d : dist) {
+                if (d != std::numeric_limits<double>::infinity()) {
+                    result.checksum += d;
+                }
+            }
+        }
+    }
+    auto finish = std::chrono::steady_clock::now();
+    long long misses = counter.Stop();
+    result.millis = std::chrono::duration<double, std::milli>(finish - start).count() / repeats;
+    result.cache_misses = misses < 0 ? -1 : misses / repeats;
+    return result;
+}
+
+// Средний |откуда - куда| по номерам вершин: чем меньше, тем ближе в памяти соседи
+double MeanEdgeSpan(const Graph& graph) {
+    double total = 0.0;
+    for (size_t v = 0; v < graph.GetVertexCount(); ++v) {
+        for (size_t edge_id = graph.EdgesBegin(v); edge_id < graph.EdgesEnd(v); ++edge_id) {
+            size_t to = graph.GetEdgeTarget(edge_id);
+            total += static_cast<double>(to > v ? to - v : v - to);
+        }
+    }
+    return graph.GetEdgeCount() == 0 ? 0.0 : total / graph.GetEdgeCount();
+}
+
+void Report(const std::string& name, const BenchResult& result) {
+    std::cout << name << ": " << result.millis << " ms, checksum " << result.checksum;
+    if (result.cache_misses >= 0) {
+        std::cout << ", cache misses " << result.cache_misses;
+    }
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    json::Document doc = [&] {
+        if (argc > 1) {
+            std::ifstream in(argv[1]);
+            return json::Load(in);
+        }
+        return json::Load(std::cin);
+    }();
+    int repeats = argc > 2 ? std::max(std::stoi(argv[2]), 1) : 3;
+    size_t source_limit = argc > 3 ? static_cast<size_t>(std::max(std::stoi(argv[3]), 1)) : 0;
+
+    transport::TransportCatalogue tc;
+    JsonReader json_reader;
+    json_reader.ReadAndExecuteBaseRequests(tc, doc.GetRoot());
+
+    Graph graph;
+    graph.BuildGraph(tc);
+    std::cout << "stops " << graph.GetStopCount() << ", vertices " << graph.GetVertexCount()
+        << ", edges " << graph.GetEdgeCount() << "\n";
+    {
+        Graph minimized;
+        minimized.SetDropDominatedEdges(true);
+        minimized.BuildGraph(tc);
+        std::cout << "stops without buses " << graph.GetStopCount() - graph.GetServedStopCount()
+            << ", edges without dominated parallel ones " << minimized.GetEdgeCount()
+            << " (-" << 100.0 * (graph.GetEdgeCount() - minimized.GetEdgeCount()) / std::max<size_t>(graph.GetEdgeCount(), 1)
+            << "%)\n";
+    }
+
+    const size_t stop_count = graph.GetStopCount();
+    const size_t source_count = source_limit == 0 ? stop_count : std::min(source_limit, stop_count);
+    std::vector<std::string> sources;
+    sources.reserve(source_count);
+    for (size_t i = 0; i < source_count; ++i) {
+        sources.push_back(graph.GetStopName(i * stop_count / source_count));
+    }
+
+    Report("binary_heap", RunQueue<LazyBinaryHeap>(graph, sources, repeats));
+    Report("quaternary_heap", RunQueue<QuaternaryHeap>(graph, sources, repeats));
+    Report("radix_heap", RunQueue<RadixHeap>(graph, sources, repeats));
+
+    const std::pair<const char*, StopOrder> orders[] = {
+        { "catalogue", StopOrder::Catalogue },
+        { "hilbert", StopOrder::Hilbert },
+        { "bfs", StopOrder::Bfs },
+    };
+    for (const auto& [name, order] : orders) {
+        Graph ordered;
+        ordered.BuildGraph(tc, 0, order);
+        std::cout << "stop order " << name << ", mean edge span " << MeanEdgeSpan(ordered) << "\n";
+        Report(std::string("  binary_heap"), RunQueue<LazyBinaryHeap>(ordered, sources, repeats));
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "router_test_catalogue.h"
+#include "binary_io.h"
+#include "route_table.h"
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Регрессия TransportRouter::Save/Load: роутер, загруженный из файла, отвечает так же,
+// как сохраненный, во всех сохраняемых режимах - и на обычной сети, и на сети без автобусов;
+// испорченная таблица маршрутов дает binary_io::FormatError.
+// Код возврата 0 - расхождений нет.
+
+namespace {
+
+using namespace router_test;
+
+struct Network {
+    std::string name;
+    transport::TransportCatalogue tc;
+    size_t stop_count;
+};
+
+// Одна остановка и ни одного автобуса: у графа нет вершин, у таблицы Precomputed - строк
+transport::TransportCatalogue MakeEmptyCatalogue() {
+    transport::TransportCatalogue tc;
+    tc.AddRoutingSettings(6.0, 40.0);
+    tc.AddStop(StopName(0), transport::Coordinate{ 55.6, 37.5 });
+    return tc;
+}
+
+// Ребра-предки таблицы Precomputed в файле портятся: поиск по такой таблице должен
+// закончиться FormatError, а не чтением за границей графа. Расписаний у каталога нет,
+// поэтому таблица кончается перед пустым расписанием: скорость и пять пустых массивов
+bool CorruptTableIsRejected(transport::TransportCatalogue tc, const std::string& path) {
+    std::set<std::string> served;
+    for (const auto& [number, bus] : *tc.GetBuses()) {
+        tc.SetBusDepartures(number, {});
+        served.insert(bus.route.begin(), bus.route.end());
+    }
+    RouterSettings settings;
+    settings.threads = 2;
+    TransportRouter(tc, settings).Save(path);
+
+    const size_t vertex_count = served.size() * 2;
+    const size_t table_bytes = served.size() * vertex_count * sizeof(RouteCell);
+    const size_t timetable_bytes = sizeof(double) + 5 * sizeof(uint64_t);
+    const size_t file_size = static_cast<size_t>(std::filesystem::file_size(path));
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t bad_edge = RouteCell::kNoEdge - 1;
+        for (size_t cell = 0; cell < table_bytes / sizeof(RouteCell); ++cell) {
+            file.seekp(static_cast<std::streamoff>(file_size - timetable_bytes - table_bytes
+                + cell * sizeof(RouteCell) + offsetof(RouteCell, prev_edge)));
+            file.write(reinterpret_cast<const char*>(&bad_edge), sizeof(bad_edge));
+        }
+    }
+    std::unique_ptr<TransportRouter> loaded = TransportRouter::Load(path);
+    const std::string from = *served.begin();
+    const std::string to = *served.rbegin();
+    try {
+        loaded->FindRoute(from, to);
+    }
+    catch (const binary_io::FormatError&) {
+        return true;
+    }
+    std::cerr << "corrupt route table: no FormatError for " << from << " -> " << to << "\n";
+    return false;
+}
+
+} // namespace
+
+int main() {
+    std::vector<Network> networks;
+    std::mt19937 rng(17);
+    networks.push_back({ "normal", MakeCatalogue(rng), kStopCount });
+    networks.push_back({ "empty", MakeEmptyCatalogue(), 1 });
+
+    std::vector<RouterSettings> configs;
+    for (RoutingMode mode : { RoutingMode::Precomputed, RoutingMode::OnDemand, RoutingMode::Bidirectional,
+        RoutingMode::AStar, RoutingMode::Contraction, RoutingMode::HubLabels }) {
+        RouterSettings settings;
+        settings.mode = mode;
+        settings.threads = 2;
+        configs.push_back(settings);
+    }
+    RouterSettings minimized;
+    minimized.threads = 2;
+    minimized.minimize_graph = true;
+    minimized.stop_order = StopOrder::Bfs;
+    configs.push_back(minimized);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "router_save_test.db").string();
+    size_t failures = 0;
+    for (const Network& network : networks) {
+        for (const RouterSettings& settings : configs) {
+            const std::string label = network.name + ", " + ModeName(settings.mode)
+                + (settings.minimize_graph ? " minimized" : "");
+            TransportRouter saved(network.tc, settings);
+            try {
+                saved.Save(path);
+                std::unique_ptr<TransportRouter> loaded = TransportRouter::Load(path);
+                failures += CompareRouters(*loaded, saved, label, network.stop_count);
+            }
+            catch (const std::exception& e) {
+                std::cerr << label << ": " << e.what() << "\n";
+                ++failures;
+            }
+        }
+    }
+    {
+        std::mt19937 corrupt_rng(17);
+        if (!CorruptTableIsRejected(MakeCatalogue(corrupt_rng), path)) {
+            ++failures;
+        }
+    }
+    std::remove(path.c_str());
+    if (failures > 0) {
+        std::cerr << failures << " mismatches\n";
+        return 1;
+    }
+    std::cout << "router save/load: " << networks.size() * configs.size() << " cases match\n";
+    return 0;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Общее для регрессий роутера: воспроизводимый по seed каталог и сравнение двух роутеров
+namespace router_test {
+
+inline constexpr size_t kStopCount = 40;
+inline constexpr size_t kServedStops = 36;// остальные остаются без автобусов
+
+inline std::string StopName(size_t i) {
+    return "S" + std::to_string(i);
+}
+
+// Маршруты сравниваются по времени: при равных по времени путях ребра могут отличаться
+inline bool SameTime(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-9 * std::max(1.0, std::abs(rhs));
+}
+
+inline void AddBusWithDistances(transport::TransportCatalogue& tc, std::mt19937& rng, const std::string& number,
+    const std::vector<std::string>& stops, bool is_ring) {
+    std::uniform_int_distribution<int> distance(300, 3000);
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        if (tc.GetRoadDistance(stops[i], stops[i + 1]) == 0) {
+            tc.SetRoadDistance(stops[i], stops[i + 1], distance(rng));
+        }
+        if (!is_ring && tc.GetRoadDistance(stops[i + 1], stops[i]) == 0) {
+            tc.SetRoadDistance(stops[i + 1], stops[i], distance(rng));
+        }
+    }
+    tc.AddBus(number, stops, is_ring);
+    tc.SetBusDepartures(number, { 360.0, 375.0, 390.0, 420.0 });
+}
+
+inline std::vector<std::string> RandomRoute(std::mt19937& rng, size_t length) {
+    std::uniform_int_distribution<size_t> stop(0, kServedStops - 1);
+    std::vector<std::string> route;
+    while (route.size() < length) {
+        std::string name = StopName(stop(rng));
+        if (route.empty() || route.back() != name) {
+            route.push_back(std::move(name));
+        }
+    }
+    return route;
+}
+
+inline transport::TransportCatalogue MakeCatalogue(std::mt19937& rng) {
+    transport::TransportCatalogue tc;
+    tc.AddRoutingSettings(6.0, 40.0);
+    std::uniform_real_distribution<double> offset(0.0, 0.05);
+    for (size_t i = 0; i < kStopCount; ++i) {
+        tc.AddStop(StopName(i), transport::Coordinate{ 55.6 + offset(rng), 37.5 + offset(rng) });
+    }
+    std::uniform_int_distribution<size_t> length(3, 8);
+    for (size_t b = 0; b < 12; ++b) {
+        std::vector<std::string> route = RandomRoute(rng, length(rng));
+        const bool is_ring = b % 4 == 0;
+        if (is_ring) {
+            route.push_back(route.front());
+        }
+        AddBusWithDistances(tc, rng, "B" + std::to_string(b), route, is_ring);
+    }
+    return tc;
+}
+
+// Число расхождений got с want по всем парам из stop_count первых остановок
+inline size_t CompareRouters(const TransportRouter& got_router, const TransportRouter& want_router,
+    const std::string& label, size_t stop_count = kStopCount) {
+    size_t mismatches = 0;
+    auto report = [&](const std::string& from, const std::string& to, const char* what) {
+        if (++mismatches <= 5) {
+            std::cerr << label << ": " << what << " differs for " << from << " -> " << to << "\n";
+        }
+    };
+    for (size_t i = 0; i < stop_count; ++i) {
+        for (size_t j = 0; j < stop_count; ++j) {
+            const std::string from = StopName(i);
+            const std::string to = StopName(j);
+            RouteResult got = got_router.FindRoute(from, to);
+            RouteResult want = want_router.FindRoute(from, to);
+            if (got.found != want.found || (want.found && !SameTime(got.total_time, want.total_time))) {
+                report(from, to, "Route");
+            }
+            std::optional<double> got_time = got_router.FindTravelTime(from, to);
+            std::optional<double> want_time = want_router.FindTravelTime(from, to);
+            if (got_time.has_value() != want_time.has_value() || (want_time && !SameTime(*got_time, *want_time))) {
+                report(from, to, "TravelTime");
+            }
+            RouteResult got_at = got_router.FindRouteAt(from, to, 350.0);
+            RouteResult want_at = want_router.FindRouteAt(from, to, 350.0);
+            if (got_at.found != want_at.found || (want_at.found && !SameTime(got_at.total_time, want_at.total_time))) {
+                report(from, to, "Route at departure_time");
+            }
+        }
+    }
+    return mismatches;
+}
+
+inline std::string ModeName(RoutingMode mode) {
+    switch (mode) {
+    case RoutingMode::Precomputed: return "precomputed";
+    case RoutingMode::OnDemand: return "on_demand";
+    case RoutingMode::Bidirectional: return "bidirectional";
+    case RoutingMode::AStar: return "astar";
+    case RoutingMode::Contraction: return "contraction";
+    case RoutingMode::HubLabels: return "hub_labels";
+    case RoutingMode::RoutePatterns: return "route_patterns";
+    }
+    return "unknown";
+}
+
+} // namespace router_test
@@ -0,0 +1,100 @@
+#include "router_test_catalogue.h"
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Регрессия TransportRouter::Update: после каждого изменения каталога (Bus, RemoveBus,
+// Distance - как в update_requests) ответы обновленного роутера сравниваются с ответами
+// роутера, построенного по тому же каталогу заново, во всех режимах.
+// Код возврата 0 - расхождений нет.
+
+namespace {
+
+using namespace router_test;
+
+struct Scenario {
+    std::string name;
+    std::function<void(transport::TransportCatalogue&)> apply;
+};
+
+// Отрезок пути первого автобуса: его расстояние меняется в шагах Distance
+std::pair<std::string, std::string> FirstSegment(const transport::TransportCatalogue& tc, const std::string& bus) {
+    const auto& route = tc.GetBus(bus)->route;
+    return { route[0], route[1] };
+}
+
+std::vector<Scenario> MakeScenarios(std::mt19937& rng) {
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({ "Distance down", [](transport::TransportCatalogue& tc) {
+        auto [from, to] = FirstSegment(tc, "B1");
+        tc.SetRoadDistance(from, to, tc.GetRoadDistance(from, to) / 4 + 1);
+    } });
+    scenarios.push_back({ "Distance up", [](transport::TransportCatalogue& tc) {
+        auto [from, to] = FirstSegment(tc, "B2");
+        tc.SetRoadDistance(from, to, tc.GetRoadDistance(from, to) * 5);
+    } });
+    scenarios.push_back({ "RemoveBus", [](transport::TransportCatalogue& tc) {
+        tc.RemoveBus("B3");
+    } });
+    scenarios.push_back({ "Bus new", [&rng](transport::TransportCatalogue& tc) {
+        AddBusWithDistances(tc, rng, "N1", RandomRoute(rng, 6), false);
+    } });
+    scenarios.push_back({ "Bus replace", [](transport::TransportCatalogue& tc) {
+        std::vector<std::string> route = tc.GetBus("B5")->route;
+        route.resize(2);
+        tc.RemoveBus("B5");
+        tc.AddBus("B5", route, false);
+    } });
+    // новая обслуживаемая остановка меняет нумерацию - Update перестраивает граф целиком
+    scenarios.push_back({ "Bus new stops", [&rng](transport::TransportCatalogue& tc) {
+        std::vector<std::string> route = RandomRoute(rng, 3);
+        route.push_back(StopName(kServedStops));
+        route.push_back(StopName(kServedStops + 1));
+        AddBusWithDistances(tc, rng, "N2", route, false);
+    } });
+    return scenarios;
+}
+
+} // namespace
+
+int main() {
+    std::vector<RouterSettings> configs;
+    for (RoutingMode mode : { RoutingMode::Precomputed, RoutingMode::OnDemand, RoutingMode::Bidirectional,
+        RoutingMode::AStar, RoutingMode::Contraction, RoutingMode::HubLabels, RoutingMode::RoutePatterns }) {
+        RouterSettings settings;
+        settings.mode = mode;
+        settings.threads = 2;
+        configs.push_back(settings);
+    }
+    // прореживание ребер и другая нумерация меняют номера ребер, которые Update перенумеровывает
+    for (RoutingMode mode : { RoutingMode::Precomputed, RoutingMode::OnDemand }) {
+        RouterSettings settings;
+        settings.mode = mode;
+        settings.threads = 2;
+        settings.minimize_graph = true;
+        settings.stop_order = StopOrder::Hilbert;
+        configs.push_back(settings);
+    }
+
+    size_t failures = 0;
+    for (const RouterSettings& settings : configs) {
+        std::mt19937 rng(17);
+        transport::TransportCatalogue tc = MakeCatalogue(rng);
+        TransportRouter router(tc, settings);
+        std::string config = ModeName(settings.mode) + (settings.minimize_graph ? " minimized" : "");
+        for (const Scenario& scenario : MakeScenarios(rng)) {
+            scenario.apply(tc);
+            router.Update(tc);
+            TransportRouter fresh(tc, settings);
+            failures += CompareRouters(router, fresh, config + ", " + scenario.name);
+        }
+    }
+    if (failures > 0) {
+        std::cerr << failures << " mismatches\n";
+        return 1;
+    }
+    std::cout << "router update: " << configs.size() << " configurations match a fresh build\n";
+    return 0;
+}
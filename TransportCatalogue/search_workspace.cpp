@@ -0,0 +1,47 @@
+#include "search_workspace.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+    std::vector<std::unique_ptr<SearchWorkspace>>& ThreadPool() {
+        thread_local std::vector<std::unique_ptr<SearchWorkspace>> pool;
+        return pool;
+    }
+}
+
+SearchWorkspace::Lease::Lease(std::unique_ptr<SearchWorkspace> workspace)
+    : workspace_(std::move(workspace)) {
+}
+
+SearchWorkspace::Lease::~Lease() {
+    if (workspace_) {
+        ThreadPool().push_back(std::move(workspace_));
+    }
+}
+
+SearchWorkspace::Lease SearchWorkspace::Borrow(size_t vertex_count) {
+    auto& pool = ThreadPool();
+    std::unique_ptr<SearchWorkspace> workspace;
+    if (pool.empty()) {
+        workspace = std::make_unique<SearchWorkspace>();
+    }
+    else {
+        workspace = std::move(pool.back());
+        pool.pop_back();
+    }
+    workspace->Begin(vertex_count);
+    return Lease(std::move(workspace));
+}
+
+void SearchWorkspace::Begin(size_t vertex_count) {
+    queue_.Reset(vertex_count);
+    if (++epoch_ == 0) {
+        // счетчик обошел круг: старые отметки могли бы совпасть с новыми
+        std::fill(slots_.begin(), slots_.end(), Slot{ 0.0, 0, kNoEdge });
+        epoch_ = 1;
+    }
+    if (slots_.size() < vertex_count) {
+        // новые вершины получают отметку 0, а эпоха уже не меньше 1
+        slots_.resize(vertex_count, Slot{ 0.0, 0, kNoEdge });
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "priority_queues.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Рабочие массивы одного поиска по графу: время и ребро-предок каждой вершины плюс куча.
+// Значение вершины действительно, только если ее отметка равна текущей эпохе, поэтому
+// новый поиск не чистит массивы размером в граф - Begin лишь увеличивает эпоху, и поиск
+// малого радиуса стоит столько, сколько вершин он тронул.
+// Пространства живут в пуле своего потока и выдаются поиску на время через Borrow.
+class SearchWorkspace {
+public:
+    static constexpr uint32_t kNoEdge = std::numeric_limits<uint32_t>::max();
+
+    // Выданное пространство; при разрушении возвращается в пул текущего потока
+    class Lease {
+    public:
+        explicit Lease(std::unique_ptr<SearchWorkspace> workspace);
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&&) = default;
+        ~Lease();
+
+        SearchWorkspace& operator*() const {
+            return *workspace_;
+        }
+        SearchWorkspace* operator->() const {
+            return workspace_.get();
+        }
+    private:
+        std::unique_ptr<SearchWorkspace> workspace_;
+    };
+
+    // Пространство из пула потока (или новое), уже готовое к поиску на vertex_count вершинах.
+    // Вложенные поиски (двунаправленный, ответвления Йена) берут по пространству на сторону
+    static Lease Borrow(size_t vertex_count);
+
+    // Очередь типа Queue текущего потока: ее память переживает поиски
+    template <typename Queue>
+    static Queue& ThreadQueue() {
+        thread_local Queue queue;
+        return queue;
+    }
+
+    // Начинает новый поиск: все вершины недостигнуты, куча пуста
+    void Begin(size_t vertex_count);
+
+    bool Reached(size_t v) const {
+        return slots_[v].epoch == epoch_;
+    }
+    double Dist(size_t v) const {
+        return Reached(v) ? slots_[v].dist : std::numeric_limits<double>::infinity();
+    }
+    uint32_t PrevEdge(size_t v) const {
+        return Reached(v) ? slots_[v].prev_edge : kNoEdge;
+    }
+    void Set(size_t v, double dist, uint32_t prev_edge) {
+        slots_[v] = Slot{ dist, epoch_, prev_edge };
+    }
+    LazyBinaryHeap& Queue() {
+        return queue_;
+    }
+private:
+    // время, отметка и предок рядом: релаксация трогает одну строку кэша
+    struct Slot {
+        double dist;
+        uint32_t epoch;
+        uint32_t prev_edge;
+    };
+
+    uint32_t epoch_ = 0;
+    std::vector<Slot> slots_;
+    LazyBinaryHeap queue_;
+};
@@ -0,0 +1,102 @@
+#include "stop_order.h"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+namespace {
+    constexpr uint32_t kHilbertBits = 16;
+
+    // Номер клетки (x, y) на кривой Гильберта порядка kHilbertBits
+    uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+        const uint32_t n = 1u << kHilbertBits;
+        uint64_t d = 0;
+        for (uint32_t s = 1u << (kHilbertBits - 1); s > 0; s >>= 1) {
+            uint32_t rx = (x & s) ? 1 : 0;
+            uint32_t ry = (y & s) ? 1 : 0;
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // поворот четверти, чтобы кривая внутри нее шла в нужную сторону
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    uint32_t ToGrid(double value, double min, double max) {
+        const double cells = static_cast<double>((1u << kHilbertBits) - 1);
+        if (max <= min) {
+            return 0;
+        }
+        return static_cast<uint32_t>((value - min) / (max - min) * cells);
+    }
+}
+
+std::vector<uint32_t> OrderStopsByHilbert(const std::vector<geo::Coordinates>& coordinates) {
+    std::vector<uint32_t> order(coordinates.size());
+    std::iota(order.begin(), order.end(), 0u);
+    if (coordinates.empty()) {
+        return order;
+    }
+    double min_lat = coordinates[0].lat;
+    double max_lat = min_lat;
+    double min_lng = coordinates[0].lng;
+    double max_lng = min_lng;
+    for (const geo::Coordinates& c : coordinates) {
+        min_lat = std::min(min_lat, c.lat);
+        max_lat = std::max(max_lat, c.lat);
+        min_lng = std::min(min_lng, c.lng);
+        max_lng = std::max(max_lng, c.lng);
+    }
+    std::vector<uint64_t> keys(coordinates.size());
+    for (size_t i = 0; i < coordinates.size(); ++i) {
+        keys[i] = HilbertIndex(ToGrid(coordinates[i].lng, min_lng, max_lng), ToGrid(coordinates[i].lat, min_lat, max_lat));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return keys[lhs] < keys[rhs];
+    });
+    return order;
+}
+
+std::vector<uint32_t> OrderStopsByBfs(const std::vector<std::vector<uint32_t>>& neighbours) {
+    const size_t n = neighbours.size();
+    auto by_degree = [&](uint32_t lhs, uint32_t rhs) {
+        if (neighbours[lhs].size() != neighbours[rhs].size()) {
+            return neighbours[lhs].size() < neighbours[rhs].size();
+        }
+        return lhs < rhs;
+    };
+    // кандидаты в начало компоненты
+    std::vector<uint32_t> starts(n);
+    std::iota(starts.begin(), starts.end(), 0u);
+    std::sort(starts.begin(), starts.end(), by_degree);
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<uint32_t> next;
+    for (uint32_t start : starts) {
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = 1;
+        // order сам служит очередью: голова - первая необработанная остановка компоненты
+        size_t head = order.size();
+        order.push_back(start);
+        for (; head < order.size(); ++head) {
+            next.clear();
+            for (uint32_t to : neighbours[order[head]]) {
+                if (!visited[to]) {
+                    visited[to] = 1;
+                    next.push_back(to);
+                }
+            }
+            std::sort(next.begin(), next.end(), by_degree);
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    return order;
+}
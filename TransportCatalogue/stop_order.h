@@ -0,0 +1,21 @@
+#pragma once
+#include "geo.h"
+#include <cstdint>
+#include <vector>
+
+// Порядок номеров остановок в графе. Вершины остановки - 2·idx и 2·idx+1, так что
+// близкие номера остановок - это близкие строки массивов расстояний и ребер.
+// Имена остаются ключами, поэтому порядок на ответы не влияет, кроме выбора среди
+// маршрутов с одинаковым временем.
+enum class StopOrder {
+    Catalogue,// порядок обхода каталога (unordered_map), по умолчанию
+    Hilbert,  // по кривой Гильберта над координатами: соседи по карте рядом
+    Bfs,      // обход в ширину по перегонам (Катхилл-Макки): соседи по маршрутам рядом
+};
+
+// Перестановки order[new_idx] = old_idx.
+// Остановки с одинаковым ключом кривой сохраняют исходный порядок
+std::vector<uint32_t> OrderStopsByHilbert(const std::vector<geo::Coordinates>& coordinates);
+// neighbours[idx] - остановки, соседние с idx по какому-нибудь маршруту. Каждая компонента
+// обходится от вершины с наименьшей степенью, соседи - по возрастанию степени
+std::vector<uint32_t> OrderStopsByBfs(const std::vector<std::vector<uint32_t>>& neighbours);
@@ -1,4 +1,5 @@
 #include "transport_catalogue.h"
+#include <algorithm>
 #include <unordered_set>
 #include "geo.h"
 
@@ -20,6 +21,10 @@ namespace transport {
         return 0;
     }
 
+    const std::unordered_map<std::pair<std::string, std::string>, double, StringPairHasher>* TransportCatalogue::GetRoadDistances() const {
+        return &road_distances_;
+    }
+
     void TransportCatalogue::AddStop(const std::string& name, const Coordinate& coordinate) {
         stops_.emplace(name, Stop{ name, coordinate });
     }
@@ -38,6 +43,33 @@ namespace transport {
         }
     }
 
+    bool TransportCatalogue::RemoveBus(const std::string_view number) {
+        auto it = buses_.find(std::string(number));
+        if (it == buses_.end()) {
+            return false;
+        }
+        // в stop_to_buses_ лежат string_view на ключ buses_, убираем их до удаления автобуса
+        const std::string& bus_number = it->first;
+        for (const auto& stop_name : it->second.route) {
+            auto stop_it = stop_to_buses_.find(stop_name);
+            if (stop_it != stop_to_buses_.end()) {
+                stop_it->second.erase(bus_number);
+            }
+        }
+        buses_.erase(it);
+        return true;
+    }
+
+    bool TransportCatalogue::SetBusDepartures(const std::string_view number, std::vector<double> departures) {
+        auto it = buses_.find(std::string(number));
+        if (it == buses_.end()) {
+            return false;
+        }
+        std::sort(departures.begin(), departures.end());
+        it->second.departures = std::move(departures);
+        return true;
+    }
+
     const Stop* TransportCatalogue::GetStop(const std::string_view name) const {
         auto it = stops_.find(name.data());
         if (it == stops_.end()) return nullptr;
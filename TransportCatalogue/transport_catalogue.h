@@ -29,6 +29,10 @@ namespace transport {
         std::string number;
         std::vector<std::string> route;
         bool is_ring = false;
+        // отправления от первой остановки, минуты от начала суток по возрастанию;
+        // у некольцевого маршрута обратные рейсы уходят с конечной в те же моменты.
+        // Пусто - расписания нет, автобус не участвует в поиске по времени отправления
+        std::vector<double> departures;
     };
 
     class TransportCatalogue {
@@ -42,9 +46,14 @@ namespace transport {
 
         void AddStop(const std::string& name, const Coordinate& coordinate);
         void AddBus(const std::string& number, const std::vector<std::string>& stop_names, bool is_ring);
+        // false, если такого автобуса нет
+        bool RemoveBus(const std::string_view number);
+        // false, если такого автобуса нет; моменты сортируются
+        bool SetBusDepartures(const std::string_view number, std::vector<double> departures);
 
         void SetRoadDistance(const std::string_view from_stop, const std::string_view to_stop, double distance);
         int GetRoadDistance(const std::string_view from_stop, const std::string_view to_stop) const;
+        const std::unordered_map<std::pair<std::string, std::string>, double, StringPairHasher>* GetRoadDistances() const;
 
         const Stop* GetStop(std::string_view name) const;
         const std::unordered_map<std::string, Stop>* GetStops() const;
@@ -1,68 +1,781 @@
 #include "transport_router.h"
 #include "graph.h"
+#include "graph_search.h"
 #include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <limits>
+#include <stdexcept>
+#include <unordered_map>
 
-TransportRouter::TransportRouter(const transport::TransportCatalogue& tc){
-    graph_.BuildGraph(tc);
+namespace {
+
+constexpr char kRouterMagic[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', 'R' };
+constexpr uint32_t kRouterVersion = 5;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+} // namespace
+
+TransportRouter::TransportRouter(const transport::TransportCatalogue& tc, const RouterSettings& settings)
+    : settings_(settings) {
+    Rebuild(tc);
+    SetResultCacheCapacity(settings_.result_cache_entries);
+}
+
+void TransportRouter::Rebuild(const transport::TransportCatalogue& tc) {
+    if (settings_.mode == RoutingMode::RoutePatterns) {
+        // квадратичный граф не нужен, только нумерация остановок и автобусов
+        graph_.BuildStopIndex(tc, settings_.stop_order);
+        route_patterns_.Build(tc, graph_);
+        timetable_.Build(tc, graph_);
+        return;
+    }
+    graph_.SetDropDominatedEdges(settings_.minimize_graph);
+    graph_.BuildGraph(tc, settings_.threads, settings_.stop_order);
+    timetable_.Build(tc, graph_);
+    if (settings_.mode == RoutingMode::Precomputed) {
+        graph_.PrecomputeAllRoutes(settings_.threads, settings_.queue, settings_.huge_pages);
+    }
+    PrepareSearch();
+}
+
+void TransportRouter::Update(const transport::TransportCatalogue& tc) {
+    // ответы считались по старому каталогу, счетчики при этом не сбрасываются
+    if (result_cache_) {
+        result_cache_->Clear();
+    }
+    // шаблоны маршрутов строятся за линейное время и опираются на порядок автобусов в каталоге
+    if (settings_.mode == RoutingMode::RoutePatterns || !graph_.HasSameStops(tc)) {
+        // настройки сессии переживают перестройку, как и при UpdateEdges
+        const EdgeWeights weights = GetEdgeWeights();
+        Rebuild(tc);
+        SetEdgeWeights(weights);
+        return;
+    }
+    Graph::EdgeDiff diff = graph_.UpdateEdges(tc, settings_.threads);
+    timetable_.Build(tc, graph_);
+    timetable_.SetSpeed(graph_.GetEdgeWeights().speed_m_per_min);
+    if (settings_.mode == RoutingMode::Precomputed) {
+        graph_.UpdateAllRoutes(diff, settings_.threads, settings_.queue);
+    }
+    // остальные индексы выводятся из графа целиком, кэш деревьев создается пустым
+    PrepareSearch();
+}
+
+void TransportRouter::PrepareSearch() {
+    // буферы альтернатив по размеру старого графа
+    k_paths_pool_.clear();
+    switch (settings_.mode) {
+    case RoutingMode::Precomputed:
+    case RoutingMode::RoutePatterns:
+        break;
+    case RoutingMode::OnDemand:
+        tree_cache_ = std::make_unique<RouteTreeCache>(settings_.tree_cache_bytes);
+        break;
+    case RoutingMode::Bidirectional:
+        graph_.BuildReverseAdjacency();
+        break;
+    case RoutingMode::AStar:
+        geo_lower_bound_ = ComputeGeoLowerBound(graph_);
+        break;
+    case RoutingMode::Contraction:
+        hierarchy_.Build(graph_);
+        break;
+    case RoutingMode::HubLabels:
+        graph_.BuildReverseAdjacency();
+        hub_labels_.Build(graph_);
+        break;
+    }
+}
+
+void TransportRouter::Save(const std::string& path) const {
+    using namespace std::literals;
+    if (!CanSave(settings_.mode)) {
+        throw std::runtime_error("route_patterns mode cannot be saved"s);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create "s + path);
+    }
+    binary_io::Writer writer(out);
+    writer.WriteBytes(kRouterMagic, sizeof(kRouterMagic));
+    writer.Write(kRouterVersion);
+    writer.Write(kByteOrderMark);
+    writer.Write<uint32_t>(static_cast<uint32_t>(settings_.mode));
+    writer.Write<uint64_t>(settings_.tree_cache_bytes);
+    writer.Write<uint64_t>(settings_.threads);
+    writer.Write<uint32_t>(static_cast<uint32_t>(settings_.queue));
+    writer.Write<uint8_t>(settings_.huge_pages ? 1 : 0);
+    writer.Write<uint32_t>(static_cast<uint32_t>(settings_.stop_order));
+    writer.Write<uint8_t>(settings_.minimize_graph ? 1 : 0);
+    graph_.Serialize(writer);
+    timetable_.Serialize(writer);
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write "s + path);
+    }
+}
+
+std::unique_ptr<TransportRouter> TransportRouter::Load(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    binary_io::Reader reader(file->GetData(), file->GetSize());
+
+    char magic[sizeof(kRouterMagic)];
+    for (char& c : magic) {
+        c = reader.Read<char>();
+    }
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(kRouterMagic))) {
+        throw binary_io::FormatError("Not a router file: " + path);
+    }
+    if (reader.Read<uint32_t>() != kRouterVersion) {
+        throw binary_io::FormatError("Unsupported router file version: " + path);
+    }
+    if (reader.Read<uint32_t>() != kByteOrderMark) {
+        throw binary_io::FormatError("Router file has a different byte order: " + path);
+    }
+
+    std::unique_ptr<TransportRouter> router(new TransportRouter());
+    RouterSettings& settings = router->settings_;
+    uint32_t mode = reader.Read<uint32_t>();
+    if (mode > static_cast<uint32_t>(RoutingMode::HubLabels)) {
+        throw binary_io::FormatError("Unknown routing mode in router file: " + path);
+    }
+    settings.mode = static_cast<RoutingMode>(mode);
+    settings.tree_cache_bytes = static_cast<size_t>(reader.Read<uint64_t>());
+    settings.threads = static_cast<size_t>(reader.Read<uint64_t>());
+    uint32_t queue = reader.Read<uint32_t>();
+    if (queue > static_cast<uint32_t>(QueueKind::RadixHeap)) {
+        throw binary_io::FormatError("Unknown queue kind in router file: " + path);
+    }
+    settings.queue = static_cast<QueueKind>(queue);
+    settings.huge_pages = reader.Read<uint8_t>() != 0;
+    uint32_t stop_order = reader.Read<uint32_t>();
+    if (stop_order > static_cast<uint32_t>(StopOrder::Bfs)) {
+        throw binary_io::FormatError("Unknown stop order in router file: " + path);
+    }
+    settings.stop_order = static_cast<StopOrder>(stop_order);
+    settings.minimize_graph = reader.Read<uint8_t>() != 0;
+
+    router->graph_.Deserialize(reader, file);
+    // ребра в файле уже прорежены, флаг нужен для будущих Update
+    router->graph_.SetDropDominatedEdges(settings.minimize_graph);
+    router->timetable_.Deserialize(reader, router->graph_.GetStopCount(), router->graph_.GetBusCount());
+    if (settings.mode == RoutingMode::Precomputed && !router->graph_.HasAllRoutes()) {
+        throw binary_io::FormatError("Router file has no route table: " + path);
+    }
+    router->PrepareSearch();
+    return router;
+}
+
+std::shared_ptr<const ShortestPathTree> TransportRouter::GetTree(size_t stop_idx) const {
+    if (auto tree = tree_cache_->Find(stop_idx)) {
+        return tree;
+    }
+    return tree_cache_->Insert(stop_idx, graph_.BuildShortestPathTree(stop_idx, settings_.queue));
 }
 
 RouteResult TransportRouter::FindRoute(const std::string& from, const std::string& to) const {
-        RouteResult result;
+    RouteResult result;
+    FindRoute(from, to, result);
+    return result;
+}
+
+bool TransportRouter::FindRoute(const std::string& from, const std::string& to, RouteResult& result) const {
+    result.found = false;
+    result.total_time = 0.0;
+    result.items.clear();
+
+    auto it_from = graph_.GetStopToIndex().find(from);
+    auto it_to = graph_.GetStopToIndex().find(to);
+    if (it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
+        return false;
+    }
+
+    if (from == to) {
+        result.found = true;
+        return true;
+    }
+    // через остановку без автобусов никуда не уехать
+    if (!graph_.HasVertices(it_from->second) || !graph_.HasVertices(it_to->second)) {
+        return false;
+    }
+
+    if (result_cache_) {
+        if (auto cached = result_cache_->Find(it_from->second, it_to->second)) {
+            result = *cached;
+            return result.found;
+        }
+    }
+
+    switch (settings_.mode) {
+    case RoutingMode::RoutePatterns:
+        FindRouteByPatterns(it_from->second, it_to->second, result);
+        break;
+    case RoutingMode::Precomputed:
+    case RoutingMode::OnDemand:
+        result.found = FindRouteInTree(GetTreeView(it_from->second), it_to->second, result);
+        break;
+    case RoutingMode::Bidirectional:
+    case RoutingMode::AStar:
+    case RoutingMode::Contraction:
+    case RoutingMode::HubLabels: {
+        std::vector<size_t> path_edges;
+        if (FindPathBetween(it_from->second, it_to->second, path_edges)) {
+            result.found = true;
+            FillEdgeItems(path_edges, graph_.GetEdgeWeights(), result);
+        }
+        break;
+    }
+    }
+
+    if (result_cache_) {
+        result_cache_->Insert(it_from->second, it_to->second, std::make_shared<const RouteResult>(result));
+    }
+    return result.found;
+}
+
+bool TransportRouter::FindRoute(const std::string& from, const std::string& to, const EdgeWeights& weights,
+    RouteResult& result) const {
+    if (weights == GetEdgeWeights()) {
+        return FindRoute(from, to, result);
+    }
+    result.found = false;
+    result.total_time = 0.0;
+    result.items.clear();
+
+    auto it_from = graph_.GetStopToIndex().find(from);
+    auto it_to = graph_.GetStopToIndex().find(to);
+    if (it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
+        return false;
+    }
+    if (from == to) {
+        result.found = true;
+        return true;
+    }
+    if (!graph_.HasVertices(it_from->second) || !graph_.HasVertices(it_to->second)) {
+        return false;
+    }
+
+    if (settings_.mode == RoutingMode::RoutePatterns) {
+        if (auto journey = route_patterns_.FindJourney(it_from->second, it_to->second, weights)) {
+            result.found = true;
+            AppendJourneyItems(*journey, weights.wait_time, result);
+        }
+        return result.found;
+    }
+    // одна пара при других весах: ни дерева на весь граф, ни индексов режима
+    std::vector<size_t> path_edges;
+    if (graph_.FindPath(it_from->second, it_to->second, weights, path_edges)) {
+        result.found = true;
+        FillEdgeItems(path_edges, weights, result);
+    }
+    return result.found;
+}
+
+const EdgeWeights& TransportRouter::GetEdgeWeights() const {
+    // в RoutePatterns у графа нет ребер, настройки хранят шаблоны
+    return settings_.mode == RoutingMode::RoutePatterns ? route_patterns_.GetEdgeWeights() : graph_.GetEdgeWeights();
+}
+
+void TransportRouter::SetEdgeWeights(const EdgeWeights& weights) {
+    if (weights == GetEdgeWeights()) {
+        return;
+    }
+    if (result_cache_) {
+        result_cache_->Clear();
+    }
+    // перегоны расписания - расстояние на скорость, ожидание там реальное
+    timetable_.SetSpeed(weights.speed_m_per_min);
+    if (settings_.mode == RoutingMode::RoutePatterns) {
+        route_patterns_.SetEdgeWeights(weights);
+        return;
+    }
+    graph_.SetEdgeWeights(weights);
+    if (settings_.mode == RoutingMode::Precomputed) {
+        graph_.PrecomputeAllRoutes(settings_.threads, settings_.queue, settings_.huge_pages);
+    }
+    PrepareSearch();
+}
 
+void TransportRouter::SetResultCacheCapacity(size_t entries) {
+    settings_.result_cache_entries = entries;
+    if (entries == 0) {
+        result_cache_.reset();
+    }
+    else {
+        result_cache_ = std::make_unique<RouteResultCache>(entries);
+    }
+}
+
+std::optional<RouteResultCache::Stats> TransportRouter::GetResultCacheStats() const {
+    if (!result_cache_) {
+        return std::nullopt;
+    }
+    return result_cache_->GetStats();
+}
+
+std::vector<RouteResult> TransportRouter::FindRoutes(const std::string& from, const std::string& to, size_t k) const {
+    std::vector<RouteResult> routes;
+    auto it_from = graph_.GetStopToIndex().find(from);
+    auto it_to = graph_.GetStopToIndex().find(to);
+    if (k == 0 || it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
+        return routes;
+    }
+    if (from == to || settings_.mode == RoutingMode::RoutePatterns) {
+        RouteResult route = FindRoute(from, to);
+        if (route.found) {
+            routes.push_back(std::move(route));
+        }
+        return routes;
+    }
+    if (!graph_.HasVertices(it_from->second) || !graph_.HasVertices(it_to->second)) {
+        return routes;
+    }
+
+    // первый путь берется из таблицы, кэша деревьев или индекса режима, от него идут ответвления
+    std::vector<size_t> shortest;
+    if (!FindPathEdges(it_from->second, it_to->second, shortest)) {
+        return routes;
+    }
+
+    std::unique_ptr<KShortestPaths> k_paths;
+    {
+        std::lock_guard lock(k_paths_mutex_);
+        if (!k_paths_pool_.empty()) {
+            k_paths = std::move(k_paths_pool_.back());
+            k_paths_pool_.pop_back();
+        }
+    }
+    if (!k_paths) {
+        k_paths = std::make_unique<KShortestPaths>(graph_);
+    }
+    std::vector<std::vector<size_t>> paths = k_paths->Find(it_from->second * 2, it_to->second * 2, k, shortest);
+    {
+        std::lock_guard lock(k_paths_mutex_);
+        k_paths_pool_.push_back(std::move(k_paths));
+    }
+
+    routes.reserve(paths.size());
+    for (const auto& path_edges : paths) {
+        RouteResult route;
+        route.found = true;
+        FillEdgeItems(path_edges, graph_.GetEdgeWeights(), route);
+        routes.push_back(std::move(route));
+    }
+    return routes;
+}
+
+std::vector<RouteResult> TransportRouter::FindParetoRoutes(const std::string& from, const std::string& to,
+    size_t max_transfers) const {
+    std::vector<RouteResult> routes;
+    auto it_from = graph_.GetStopToIndex().find(from);
+    auto it_to = graph_.GetStopToIndex().find(to);
+    if (it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
+        return routes;
+    }
+    if (from == to) {
+        RouteResult route;
+        route.found = true;
+        routes.push_back(std::move(route));
+        return routes;
+    }
+    if (!graph_.HasVertices(it_from->second) || !graph_.HasVertices(it_to->second)) {
+        return routes;
+    }
+
+    const size_t max_rides = max_transfers + 1;
+    if (settings_.mode == RoutingMode::RoutePatterns) {
+        for (const auto& journey : route_patterns_.FindParetoJourneys(it_from->second, it_to->second, max_rides)) {
+            RouteResult route;
+            route.found = true;
+            AppendJourneyItems(journey, route_patterns_.GetWaitTime(), route);
+            routes.push_back(std::move(route));
+        }
+        return routes;
+    }
+    for (const auto& path_edges : FindParetoPaths(graph_, it_from->second, it_to->second, max_rides)) {
+        RouteResult route;
+        route.found = true;
+        FillEdgeItems(path_edges, graph_.GetEdgeWeights(), route);
+        routes.push_back(std::move(route));
+    }
+    return routes;
+}
+
+RouteResult TransportRouter::FindRouteAt(const std::string& from, const std::string& to, double departure_time) const {
+    RouteResult result;
+    auto it_from = graph_.GetStopToIndex().find(from);
+    auto it_to = graph_.GetStopToIndex().find(to);
+    if (it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
+        return result;
+    }
+
+    auto journey = timetable_.FindJourney(it_from->second, it_to->second, departure_time);
+    if (!journey) {
+        return result;
+    }
+    result.found = true;
+    result.total_time = journey->arrival - departure_time;
+    for (const auto& leg : journey->legs) {
+        RouteItem wait;
+        wait.is_wait = true;
+        wait.stop_name = graph_.GetStopName(leg.board_stop);
+        wait.time = leg.wait_time;
+        result.items.push_back(std::move(wait));
+
+        RouteItem ride;
+        ride.is_wait = false;
+        ride.bus_name = graph_.GetBusName(leg.bus_id);
+        ride.span_count = static_cast<int>(leg.span_count);
+        ride.time = leg.ride_time;
+        result.items.push_back(std::move(ride));
+    }
+    return result;
+}
+
+std::optional<double> TransportRouter::FindTravelTime(const std::string& from, const std::string& to) const {
+    if (settings_.mode == RoutingMode::HubLabels) {
         auto it_from = graph_.GetStopToIndex().find(from);
         auto it_to = graph_.GetStopToIndex().find(to);
         if (it_from == graph_.GetStopToIndex().end() || it_to == graph_.GetStopToIndex().end()) {
-            return result;
+            return std::nullopt;
+        }
+        if (!graph_.HasVertices(it_from->second) || !graph_.HasVertices(it_to->second)) {
+            return from == to ? std::optional<double>(0.0) : std::nullopt;
+        }
+        double time = hub_labels_.FindTravelTime(it_from->second * 2, it_to->second * 2);
+        if (time == std::numeric_limits<double>::infinity()) {
+            return std::nullopt;
         }
+        return time;
+    }
+    RouteResult route = FindRoute(from, to);
+    if (!route.found) {
+        return std::nullopt;
+    }
+    return route.total_time;
+}
 
-        if (from == to) {
-            result.found = true;
-            result.total_time = 0.0;
-            return result;
+std::optional<std::vector<ReachableStop>> TransportRouter::FindReachableStops(const std::string& from, double max_time) const {
+    auto it = graph_.GetStopToIndex().find(from);
+    if (it == graph_.GetStopToIndex().end()) {
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<size_t, double>> reachable;
+    if (settings_.mode == RoutingMode::RoutePatterns) {
+        // в этом режиме у графа нет ребер, ограниченный поиск идет по шаблонам маршрутов
+        std::vector<double> times = route_patterns_.FindArrivalTimes(it->second, max_time);
+        for (size_t stop = 0; stop < times.size(); ++stop) {
+            if (times[stop] <= max_time) {
+                reachable.emplace_back(stop, times[stop]);
+            }
         }
+    }
+    else if (graph_.HasVertices(it->second)) {
+        reachable = graph_.FindReachableStops(it->second, max_time);
+    }
+    else if (max_time >= 0.0) {
+        reachable.emplace_back(it->second, 0.0);
+    }
 
-        size_t from_idx = it_from->second;
-        size_t to_idx = it_to->second;
+    std::vector<ReachableStop> result;
+    result.reserve(reachable.size());
+    for (const auto& [stop, time] : reachable) {
+        result.push_back({ graph_.GetStopName(stop), time });
+    }
+    std::sort(result.begin(), result.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+        return lhs.time < rhs.time || (lhs.time == rhs.time && lhs.stop_name < rhs.stop_name);
+    });
+    return result;
+}
 
-        const auto& dist = graph_.GetAllDist()[from_idx];
-        const auto& prev_e = graph_.GetAllPrev()[from_idx];
+std::vector<std::vector<std::optional<double>>> TransportRouter::FindTravelTimeMatrix(
+    const std::vector<std::string>& from, const std::vector<std::string>& to) const {
+    const size_t kNoStop = std::numeric_limits<size_t>::max();
+    const auto& stop_to_index = graph_.GetStopToIndex();
+    auto lookup = [&](const std::string& name) {
+        auto it = stop_to_index.find(name);
+        return it == stop_to_index.end() ? kNoStop : it->second;
+    };
 
-        size_t finish_wait = to_idx * 2;
-        size_t finish_board = to_idx * 2 + 1;
-        size_t finish = (dist[finish_wait] <= dist[finish_board]) ? finish_wait : finish_board;
+    std::vector<size_t> to_idx;
+    to_idx.reserve(to.size());
+    for (const std::string& name : to) {
+        to_idx.push_back(lookup(name));
+    }
 
-        const double INF = std::numeric_limits<double>::infinity();
-        if (dist[finish] == INF) {
-            return result;
+    // повторяющиеся from считаются один раз
+    std::vector<size_t> sources;
+    std::vector<size_t> from_row(from.size(), kNoStop);
+    std::unordered_map<size_t, size_t> source_row;
+    for (size_t i = 0; i < from.size(); ++i) {
+        size_t idx = lookup(from[i]);
+        if (idx == kNoStop) {
+            continue;
         }
+        auto [it, inserted] = source_row.emplace(idx, sources.size());
+        if (inserted) {
+            sources.push_back(idx);
+        }
+        from_row[i] = it->second;
+    }
 
-        result.found = true;
-        result.total_time = dist[finish];
-
-        // восстановление пути
-        std::vector<const GraphEdge*> path_edges;
-        size_t cur = finish;
-        while (prev_e[cur] != -1) {
-            const GraphEdge* e = &graph_.GetEdges()[prev_e[cur]];
-            path_edges.push_back(e);
-            cur = e->from;
-        }
-        std::reverse(path_edges.begin(), path_edges.end());
-
-        for (const GraphEdge* e : path_edges) {
-            RouteItem item;
-            item.is_wait = e->is_wait;
-            item.time = e->weight;
-            if (e->is_wait) {
-                item.stop_name = e->stop_name;
+    std::vector<std::vector<std::optional<double>>> rows(sources.size(),
+        std::vector<std::optional<double>>(to.size()));
+    ParallelForWorkStealing(sources.size(), settings_.threads, [&](size_t /*worker*/, size_t k) {
+        FillTravelTimeRow(sources[k], to_idx, rows[k]);
+    });
+
+    std::vector<std::vector<std::optional<double>>> matrix;
+    matrix.reserve(from.size());
+    for (size_t i = 0; i < from.size(); ++i) {
+        if (from_row[i] == kNoStop) {
+            matrix.emplace_back(to.size());
+        }
+        else {
+            matrix.push_back(rows[from_row[i]]);
+        }
+    }
+    return matrix;
+}
+
+void TransportRouter::FillTravelTimeRow(size_t from_idx, const std::vector<size_t>& to_idx,
+    std::vector<std::optional<double>>& row) const {
+    const double INF = std::numeric_limits<double>::infinity();
+    // у остановок без автобусов нет ни вершин, ни строки таблицы
+    const size_t stop_count = graph_.GetServedStopCount();
+    auto set = [&](size_t k, double time) {
+        if (time != INF) {
+            row[k] = time;
+        }
+    };
+
+    if (!graph_.HasVertices(from_idx)) {
+        for (size_t k = 0; k < to_idx.size(); ++k) {
+            if (to_idx[k] == from_idx) {
+                row[k] = 0.0;
+            }
+        }
+        return;
+    }
+
+    switch (settings_.mode) {
+    case RoutingMode::Precomputed: {
+        // время складывается по ребрам пути, как в FindRoute, а не берется из float-таблицы.
+        // Путь идет от цели назад, а сумма нужна в прямом порядке, поэтому веса ребер
+        // копятся в буфере, общем для всей строки
+        TreeView view;
+        view.row = graph_.GetRouteTable().Row(from_idx);
+        std::vector<double> path_weights;
+        for (size_t k = 0; k < to_idx.size(); ++k) {
+            if (to_idx[k] >= stop_count) {
+                continue;
             }
-            else {
-                item.bus_name = e->bus_name;
-                item.span_count = e->span_count;
+            size_t finish = to_idx[k] * 2;
+            if (view.Dist(finish) == INF) {
+                continue;
+            }
+            path_weights.clear();
+            WalkPathBack(view, finish, [&](uint32_t edge_id) {
+                path_weights.push_back(graph_.GetEdgeWeight(edge_id));
+            });
+            double time = 0.0;
+            for (auto it = path_weights.rbegin(); it != path_weights.rend(); ++it) {
+                time += *it;
+            }
+            row[k] = time;
+        }
+        break;
+    }
+    case RoutingMode::HubLabels:
+        for (size_t k = 0; k < to_idx.size(); ++k) {
+            if (to_idx[k] < stop_count) {
+                set(k, hub_labels_.FindTravelTime(from_idx * 2, to_idx[k] * 2));
+            }
+        }
+        break;
+    case RoutingMode::RoutePatterns: {
+        std::vector<double> times = route_patterns_.FindArrivalTimes(from_idx);
+        for (size_t k = 0; k < to_idx.size(); ++k) {
+            if (to_idx[k] < stop_count) {
+                set(k, times[to_idx[k]]);
             }
-            result.items.push_back(std::move(item));
         }
+        break;
+    }
+    default: {
+        // board-вершина цели достижима только через ее wait-вершину, смотрим wait
+        std::shared_ptr<const ShortestPathTree> tree = settings_.mode == RoutingMode::OnDemand
+            ? GetTree(from_idx)
+            : std::make_shared<const ShortestPathTree>(graph_.BuildShortestPathTree(from_idx, settings_.queue));
+        for (size_t k = 0; k < to_idx.size(); ++k) {
+            if (to_idx[k] < stop_count) {
+                set(k, tree->dist[to_idx[k] * 2]);
+            }
+        }
+        break;
+    }
+    }
 
-        return result;
+    for (size_t k = 0; k < to_idx.size(); ++k) {
+        if (to_idx[k] == from_idx) {
+            row[k] = 0.0;
+        }
+    }
+}
+
+bool TransportRouter::FindPathEdges(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const {
+    path_edges.clear();
+    if (settings_.mode == RoutingMode::Precomputed || settings_.mode == RoutingMode::OnDemand) {
+        return FindPathInTree(from_idx, to_idx, path_edges);
+    }
+    return FindPathBetween(from_idx, to_idx, path_edges);
+}
+
+TransportRouter::TreeView TransportRouter::GetTreeView(size_t from_idx) const {
+    TreeView view;
+    if (settings_.mode == RoutingMode::OnDemand) {
+        view.tree = GetTree(from_idx);
+    }
+    else {
+        view.row = graph_.GetRouteTable().Row(from_idx);
+    }
+    return view;
+}
+
+size_t TransportRouter::TreeView::FindFinish(size_t to_idx) const {
+    size_t finish_wait = to_idx * 2;
+    size_t finish_board = to_idx * 2 + 1;
+    size_t finish = (Dist(finish_wait) <= Dist(finish_board)) ? finish_wait : finish_board;
+    return Dist(finish) == std::numeric_limits<double>::infinity() ? kNoVertex : finish;
+}
+
+template <typename Fn>
+void TransportRouter::WalkPathBack(const TreeView& view, size_t finish, Fn&& fn) const {
+    size_t steps = 0;
+    for (size_t cur = finish; view.PrevEdge(cur) != RouteCell::kNoEdge;) {
+        const uint32_t edge_id = view.PrevEdge(cur);
+        if (edge_id >= graph_.GetEdgeCount() || graph_.GetEdgeTarget(edge_id) != cur
+            || ++steps > graph_.GetVertexCount()) {
+            throw binary_io::FormatError("Corrupt route table in router file");
+        }
+        fn(edge_id);
+        cur = graph_.GetEdgeSource(edge_id);
+    }
+}
+
+bool TransportRouter::FindPathInTree(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const {
+    // в режиме OnDemand view держит дерево, пока восстанавливаем путь
+    const TreeView view = GetTreeView(from_idx);
+    size_t finish = view.FindFinish(to_idx);
+    if (finish == TreeView::kNoVertex) {
+        return false;
+    }
+    WalkPathBack(view, finish, [&](uint32_t edge_id) {
+        path_edges.push_back(edge_id);
+    });
+    std::reverse(path_edges.begin(), path_edges.end());
+    return true;
+}
+
+bool TransportRouter::FindRouteInTree(const TreeView& view, size_t to_idx, RouteResult& result) const {
+    size_t finish = view.FindFinish(to_idx);
+    if (finish == TreeView::kNoVertex) {
+        return false;
+    }
+    // первый проход считает ребра, второй пишет элементы с конца на свои места:
+    // ни промежуточного вектора ребер, ни переворота
+    size_t count = 0;
+    WalkPathBack(view, finish, [&](uint32_t) {
+        ++count;
+    });
+    result.items.resize(count);
+    WalkPathBack(view, finish, [&](uint32_t edge_id) {
+        SetEdgeItem(edge_id, graph_.GetEdgeWeights(), result.items[--count]);
+    });
+    SumItemTimes(result);
+    return true;
+}
+
+bool TransportRouter::FindPathBetween(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const {
+    // board-вершина цели достижима только через ее wait-вершину
+    double time = 0.0;
+    if (settings_.mode == RoutingMode::AStar) {
+        time = FindPathAStar(graph_, from_idx * 2, to_idx * 2, geo_lower_bound_, path_edges);
+    }
+    else if (settings_.mode == RoutingMode::Contraction) {
+        time = hierarchy_.FindPath(from_idx * 2, to_idx * 2, path_edges);
+    }
+    else if (settings_.mode == RoutingMode::HubLabels) {
+        time = hub_labels_.FindPath(graph_, from_idx * 2, to_idx * 2, path_edges);
+    }
+    else {
+        time = FindPathBidirectional(graph_, from_idx * 2, to_idx * 2, path_edges);
     }
+    return time != std::numeric_limits<double>::infinity();
+}
+
+void TransportRouter::FindRouteByPatterns(size_t from_idx, size_t to_idx, RouteResult& result) const {
+    auto journey = route_patterns_.FindJourney(from_idx, to_idx);
+    if (!journey) {
+        return;
+    }
+    result.found = true;
+    AppendJourneyItems(*journey, route_patterns_.GetWaitTime(), result);
+}
+
+void TransportRouter::AppendJourneyItems(const RoutePatternRouter::Journey& journey, double wait_time,
+    RouteResult& result) const {
+    result.total_time = journey.total_time;
+    for (const auto& leg : journey.legs) {
+        RouteItem wait;
+        wait.is_wait = true;
+        wait.stop_name = graph_.GetStopName(leg.board_stop);
+        wait.time = wait_time;
+        result.items.push_back(std::move(wait));
+
+        RouteItem ride;
+        ride.is_wait = false;
+        ride.bus_name = graph_.GetBusName(leg.bus_id);
+        ride.span_count = static_cast<int>(leg.span_count);
+        ride.time = leg.ride_time;
+        result.items.push_back(std::move(ride));
+    }
+}
+
+// Превращает ребра пути в элементы ответа на месте, память items переиспользуется
+void TransportRouter::FillEdgeItems(const std::vector<size_t>& path_edges, const EdgeWeights& weights,
+    RouteResult& result) const {
+    result.items.resize(path_edges.size());
+    for (size_t i = 0; i < path_edges.size(); ++i) {
+        SetEdgeItem(path_edges[i], weights, result.items[i]);
+    }
+    SumItemTimes(result);
+}
+
+// Имена не копируются: элемент ссылается на строки графа
+void TransportRouter::SetEdgeItem(size_t edge_id, const EdgeWeights& weights, RouteItem& item) const {
+    const EdgeInfo info = graph_.GetEdgeInfo(edge_id);
+    item.is_wait = info.IsWait();
+    item.time = graph_.GetEdgeWeight(edge_id, weights);
+    if (item.is_wait) {
+        // ребро ожидания ведет из wait-вершины остановки в ее board-вершину
+        item.stop_name = graph_.GetStopName(graph_.GetEdgeTarget(edge_id) / 2);
+        item.bus_name = {};
+        item.span_count = 0;
+    }
+    else {
+        item.stop_name = {};
+        item.bus_name = graph_.GetBusName(info.bus_id);
+        item.span_count = static_cast<int>(info.span_count);
+    }
+}
+
+// total_time складывается в том же порядке, что и в прямой Дейкстре, поэтому совпадает до бита
+// с ее dist, даже если путь найден по float-таблице или другим алгоритмом
+void TransportRouter::SumItemTimes(RouteResult& result) const {
+    result.total_time = 0.0;
+    for (const RouteItem& item : result.items) {
+        result.total_time += item.time;
+    }
+}
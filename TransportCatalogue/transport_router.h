@@ -1,12 +1,26 @@
 #pragma once
+#include "connection_scan.h"
+#include "contraction_hierarchy.h"
 #include "graph.h"
+#include "hub_labels.h"
+#include "k_shortest_paths.h"
+#include "route_pattern_router.h"
+#include "route_result_cache.h"
+#include "route_tree_cache.h"
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
     struct RouteItem {
         bool is_wait;
-        std::string stop_name;  // для Wait
-        std::string bus_name;   // для Bus
+        // имена ссылаются на строки роутера и действительны до его Update или удаления
+        std::string_view stop_name;  // для Wait
+        std::string_view bus_name;   // для Bus
         int span_count = 0;
         double time = 0.0;
     };
@@ -18,11 +32,159 @@
         std::vector<RouteItem> items;
     };
 
+    // Остановка в ответе на запрос Reachable
+    struct ReachableStop {
+        std::string stop_name;
+        double time = 0.0;
+    };
+
+    enum class RoutingMode {
+        Precomputed, // все пары остановок считаются при построении роутера
+        OnDemand,    // Дейкстра от источника по запросу, деревья хранятся в LRU-кэше
+        Bidirectional, // двунаправленная Дейкстра на каждый запрос, без кэша
+        AStar,       // A* с оценкой по расстоянию по прямой (ComputeGeoLowerBound)
+        Contraction, // иерархия сжатия, строится при создании роутера
+        HubLabels,   // двухшаговая разметка, время пути - слияние двух меток
+        RoutePatterns // раунды по шаблонам маршрутов без квадратичного графа (RoutePatternRouter)
+    };
+
+    struct RouterSettings {
+        RoutingMode mode = RoutingMode::Precomputed;
+        size_t tree_cache_bytes = size_t{ 256 } * 1024 * 1024;
+        size_t threads = 0; // потоки для предвычисления, 0 - по числу ядер
+        QueueKind queue = QueueKind::BinaryHeap; // очередь Дейкстры для Precomputed/OnDemand
+        bool huge_pages = false; // таблица Precomputed на больших страницах (Linux)
+        size_t result_cache_entries = 0; // кэш готовых ответов Route, 0 - выключен; в файл роутера не пишется
+        StopOrder stop_order = StopOrder::Catalogue; // нумерация остановок в графе
+        bool minimize_graph = false; // без доминируемых параллельных ребер (Graph::SetDropDominatedEdges)
+    };
+
 class TransportRouter{
 public:
-    TransportRouter(const transport::TransportCatalogue& tc);
+    static constexpr size_t kAnyTransfers = std::numeric_limits<size_t>::max() - 1;
+
+    TransportRouter(const transport::TransportCatalogue& tc, const RouterSettings& settings = {});
     // Ищет оптимальный маршрут между двумя остановками
     RouteResult FindRoute(const std::string& from, const std::string& to) const;
+    // То же в буфер вызывающего: result перезаписывается, память items переиспользуется
+    // между запросами. Возвращает result.found
+    bool FindRoute(const std::string& from, const std::string& to, RouteResult& result) const;
+    // То же при других настройках ожидания и скорости без перестройки графа: время ребер
+    // выводится из расстояний прямо при релаксации. Таблица, индексы режима и кэши посчитаны
+    // для настроек сессии, поэтому при отличающихся weights не используются - каждый запрос
+    // строит дерево Дейкстры (в RoutePatterns - свои раунды)
+    bool FindRoute(const std::string& from, const std::string& to, const EdgeWeights& weights,
+        RouteResult& result) const;
+    // До k маршрутов без повторных остановок по возрастанию времени, первый - тот же,
+    // что у FindRoute; остальные отличаются последовательностью автобусов (KShortestPaths).
+    // В режиме RoutePatterns графа нет, и возвращается только оптимальный маршрут.
+    // Пустой вектор - нет остановки или пути
+    std::vector<RouteResult> FindRoutes(const std::string& from, const std::string& to, size_t k) const;
+    // Парето-фронт по (время, число поездок Bus): маршруты по возрастанию числа поездок,
+    // каждый следующий строго быстрее; пересадок не больше max_transfers, ограничение
+    // действует внутри поиска. Последний маршрут - самый быстрый в пределах ограничения.
+    // Пустой вектор - нет остановки или пути
+    std::vector<RouteResult> FindParetoRoutes(const std::string& from, const std::string& to,
+        size_t max_transfers = kAnyTransfers) const;
+    // Маршрут по расписаниям автобусов с отправлением не раньше departure_time (минуты от
+    // начала суток), см. ConnectionScanRouter. total_time - от departure_time до прибытия,
+    // Wait - фактическое ожидание рейса. Автобусы без расписания не используются
+    RouteResult FindRouteAt(const std::string& from, const std::string& to, double departure_time) const;
+    // Включает кэш ответов FindRoute на entries пар остановок (0 - выключает).
+    // Нельзя вызывать одновременно с поиском маршрутов
+    void SetResultCacheCapacity(size_t entries);
+    // Настройки ожидания и скорости сессии, изначально - из каталога
+    const EdgeWeights& GetEdgeWeights() const;
+    // Меняет их без перестройки графа: времена ребер пересчитываются из расстояний, затем
+    // заново считается то, что от них зависит (таблица Precomputed, индексы режима),
+    // кэши очищаются. В расписании (FindRouteAt) пересчитываются перегоны рейсов,
+    // ожидание в нем по-прежнему реальное.
+    // Нельзя вызывать одновременно с поиском маршрутов
+    void SetEdgeWeights(const EdgeWeights& weights);
+    // Счетчики кэша ответов, nullopt - кэш выключен
+    std::optional<RouteResultCache::Stats> GetResultCacheStats() const;
+    // Только время в пути, без восстановления маршрута
+    std::optional<double> FindTravelTime(const std::string& from, const std::string& to) const;
+    // Все остановки, до которых из from можно доехать не дольше max_time, по возрастанию
+    // времени (при равном - по имени); nullopt, если остановки from нет
+    std::optional<std::vector<ReachableStop>> FindReachableStops(const std::string& from, double max_time) const;
+    // Матрица времен: строка на каждую остановку from, столбец на каждую to, nullopt - нет пути
+    // или остановки. Один поиск (в Precomputed - одна строка таблицы) на каждую различную
+    // остановку from, источники обрабатываются параллельно
+    std::vector<std::vector<std::optional<double>>> FindTravelTimeMatrix(
+        const std::vector<std::string>& from, const std::vector<std::string>& to) const;
+
+    // Сохраняет граф, настройки, таблицу Precomputed и расписания в двоичный файл.
+    // Режим RoutePatterns не сохраняется (нужен каталог), ошибки - std::runtime_error
+    void Save(const std::string& path) const;
+    // Можно ли сохранить роутер в этом режиме - проверка до дорогого построения
+    static bool CanSave(RoutingMode mode) {
+        return mode != RoutingMode::RoutePatterns;
+    }
+    // Загружает роутер, сохраненный Save. Таблица Precomputed не копируется, а
+    // отображается в память; индексы остальных режимов строятся по загруженному графу.
+    // Неверный файл - binary_io::FormatError; ячейки таблицы проверяются при обходе пути
+    static std::unique_ptr<TransportRouter> Load(const std::string& path);
+
+    // Применяет изменения каталога после AddBus/RemoveBus/SetRoadDistance без полной
+    // перестройки: ребра пересобираются, а в Precomputed пересчитываются только строки,
+    // время в которых может измениться. Если изменился набор остановок, роутер строится
+    // заново. Нельзя вызывать одновременно с поиском маршрутов.
+    void Update(const transport::TransportCatalogue& tc);
 private:
+    // Строка таблицы Precomputed или дерево OnDemand, по которым восстанавливается путь
+    struct TreeView {
+        static constexpr size_t kNoVertex = std::numeric_limits<size_t>::max();
+
+        std::shared_ptr<const ShortestPathTree> tree;// держит дерево, пока читаем путь
+        const RouteCell* row = nullptr;
+
+        double Dist(size_t v) const {
+            return tree ? tree->dist[v] : row[v].dist;
+        }
+        uint32_t PrevEdge(size_t v) const {
+            return tree ? static_cast<uint32_t>(tree->prev_edge[v]) : row[v].prev_edge;
+        }
+        // вершина цели с меньшим временем, kNoVertex - недостижима
+        size_t FindFinish(size_t to_idx) const;
+    };
+
+    TransportRouter() = default;
+    // полная постройка графа и индексов режима
+    void Rebuild(const transport::TransportCatalogue& tc);
+    // строит то, что нужно режиму поверх готового графа
+    void PrepareSearch();
+    std::shared_ptr<const ShortestPathTree> GetTree(size_t stop_idx) const;
+    TreeView GetTreeView(size_t from_idx) const;
+    // ребра кратчайшего пути до wait-вершины to_idx в режимах с графом; false - пути нет
+    bool FindPathEdges(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const;
+    bool FindPathInTree(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const;
+    // Precomputed/OnDemand: элементы пишутся прямо в result в прямом порядке
+    bool FindRouteInTree(const TreeView& view, size_t to_idx, RouteResult& result) const;
+    // fn(edge) для ребер пути от finish к источнику, с конца. Строки таблицы читаются из файла
+    // как есть, поэтому ребро вне графа или не в ту вершину и путь длиннее числа вершин -
+    // binary_io::FormatError, а не чтение за границей или бесконечный обход
+    template <typename Fn>
+    void WalkPathBack(const TreeView& view, size_t finish, Fn&& fn) const;
+    bool FindPathBetween(size_t from_idx, size_t to_idx, std::vector<size_t>& path_edges) const;
+    void FindRouteByPatterns(size_t from_idx, size_t to_idx, RouteResult& result) const;
+    void AppendJourneyItems(const RoutePatternRouter::Journey& journey, double wait_time, RouteResult& result) const;
+    void FillTravelTimeRow(size_t from_idx, const std::vector<size_t>& to_idx,
+        std::vector<std::optional<double>>& row) const;
+    void FillEdgeItems(const std::vector<size_t>& path_edges, const EdgeWeights& weights, RouteResult& result) const;
+    void SetEdgeItem(size_t edge_id, const EdgeWeights& weights, RouteItem& item) const;
+    void SumItemTimes(RouteResult& result) const;
+
     Graph graph_;
+    RouterSettings settings_;
+    std::unique_ptr<RouteTreeCache> tree_cache_;
+    std::unique_ptr<RouteResultCache> result_cache_;
+    RoutePatternRouter route_patterns_;
+    ConnectionScanRouter timetable_;
+    ContractionHierarchy hierarchy_;
+    HubLabels hub_labels_;
+    double geo_lower_bound_ = 0.0;// минут на метр по прямой для AStar
+    // рабочие буферы поиска альтернатив, переживают запросы; по объекту на одновременный запрос
+    mutable std::mutex k_paths_mutex_;
+    mutable std::vector<std::unique_ptr<KShortestPaths>> k_paths_pool_;
 };
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Параллельный цикл по задачам [0, task_count) с воровством работы.
+// Каждый поток начинает со своего непрерывного диапазона и берет задачи с его начала;
+// опустошив свой диапазон, забирает вторую половину самого большого чужого.
+// fn(worker, task) вызывается ровно один раз для каждой задачи, worker < числа потоков.
+inline size_t ResolveThreadCount(size_t requested, size_t task_count) {
+    size_t threads = requested != 0 ? requested : std::thread::hardware_concurrency();
+    threads = std::max<size_t>(threads, 1);
+    return std::min(threads, std::max<size_t>(task_count, 1));
+}
+
+template <typename Fn>
+void ParallelForWorkStealing(size_t task_count, size_t thread_count, Fn&& fn) {
+    thread_count = ResolveThreadCount(thread_count, task_count);
+    if (thread_count == 1) {
+        for (size_t task = 0; task < task_count; ++task) {
+            fn(size_t{ 0 }, task);
+        }
+        return;
+    }
+
+    struct WorkRange {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    std::vector<WorkRange> ranges(thread_count);
+    for (size_t w = 0; w < thread_count; ++w) {
+        ranges[w].begin = task_count * w / thread_count;
+        ranges[w].end = task_count * (w + 1) / thread_count;
+    }
+
+    auto take_own = [&](size_t worker, size_t& task) {
+        std::lock_guard<std::mutex> lock(ranges[worker].mutex);
+        if (ranges[worker].begin == ranges[worker].end) return false;
+        task = ranges[worker].begin++;
+        return true;
+    };
+    auto steal = [&](size_t worker) {
+        for (;;) {
+            size_t victim = thread_count;
+            size_t victim_size = 0;
+            for (size_t w = 0; w < thread_count; ++w) {
+                if (w == worker) continue;
+                std::lock_guard<std::mutex> lock(ranges[w].mutex);
+                if (ranges[w].end - ranges[w].begin > victim_size) {
+                    victim_size = ranges[w].end - ranges[w].begin;
+                    victim = w;
+                }
+            }
+            if (victim == thread_count) return false;
+
+            size_t stolen_begin = 0;
+            size_t stolen_end = 0;
+            {
+                std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+                size_t size = ranges[victim].end - ranges[victim].begin;
+                if (size == 0) continue;// пока выбирали, диапазон уже разобрали
+                stolen_end = ranges[victim].end;
+                stolen_begin = stolen_end - (size + 1) / 2;
+                ranges[victim].end = stolen_begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[worker].mutex);
+            ranges[worker].begin = stolen_begin;
+            ranges[worker].end = stolen_end;
+            return true;
+        }
+    };
+
+    auto run = [&](size_t worker) {
+        size_t task = 0;
+        for (;;) {
+            while (take_own(worker, task)) {
+                fn(worker, task);
+            }
+            if (!steal(worker)) return;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t w = 1; w < thread_count; ++w) {
+        threads.emplace_back(run, w);
+    }
+    run(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+}